@@ -0,0 +1,123 @@
+// Times the set kernels of set.h against each other:
+//
+//   set_kernel_bench [graph ...]
+//
+// Graphs are DIMACS files, by default the test graphs bundled with Cliquer.
+// For every kernel table the CPU supports it times set_size over the rows
+// of each graph, intersection, union and difference over all pairs of rows,
+// and a maximum clique search. Times are shown with the speedup over the
+// scalar table, followed by a checksum of the results that must agree
+// between tables.
+#include "src/cliquer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+#ifndef CLIQUER_TESTCASES
+#define CLIQUER_TESTCASES "cliquer-1.21"
+#endif
+
+// Runs f repeatedly for at least a fifth of a second and returns the time
+// per run.
+template<class F> static double TimePerRun(F f) {
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    int runs = 0;
+    double seconds;
+    do {
+        f();
+        ++runs;
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (seconds < 0.2);
+    return seconds / runs;
+}
+
+// set_size of every row.
+static unsigned long SizeRows(graph_t* g) {
+    unsigned long checksum = 0;
+    for (int i = 0; i < g->n; ++i)
+        checksum += set_size(g->edges[i]);
+    return checksum;
+}
+
+// Intersection, union and difference of every pair of rows.
+static unsigned long CombineRows(graph_t* g) {
+    unsigned long checksum = 0;
+    set_t res = set_new(g->n);
+    set_t rest = set_new(g->n);
+    for (int i = 0; i < g->n; ++i) {
+        for (int j = 0; j < g->n; ++j) {
+            res = set_intersection(res, g->edges[i], g->edges[j]);
+            checksum += res[0];
+            res = set_union(res, g->edges[i], g->edges[j]);
+            checksum += res[0];
+            memcpy(rest, g->edges[i], SET_ARRAY_LENGTH(rest) * sizeof(setelement));
+            set_remove(rest, g->edges[j]);
+            checksum += rest[0];
+        }
+    }
+    set_free(res);
+    set_free(rest);
+    return checksum;
+}
+
+static unsigned long SearchClique(graph_t* g) {
+    clique_options options = *clique_default_options;
+    options.time_function = NULL;
+    set_t clique = graph_weighted(g)
+        ? clique_find_single(g, 0, 0, FALSE, &options)
+        : clique_unweighted_find_single(g, 0, 0, FALSE, &options);
+    unsigned long checksum = 0;
+    for (int v = -1; (v = set_return_next(clique, v)) >= 0;)
+        checksum += v;
+    set_free(clique);
+    return checksum;
+}
+
+int main(int argc, char** argv) {
+    vector<string> paths;
+    for (int i = 1; i < argc; ++i)
+        paths.push_back(argv[i]);
+    if (paths.empty()) {
+        paths.push_back(CLIQUER_TESTCASES "/testcase-small.a");
+        paths.push_back(CLIQUER_TESTCASES "/testcase-large.b");
+        paths.push_back(CLIQUER_TESTCASES "/testcase-large-w.b");
+    }
+
+    printf("%-20s %-8s %-11s %-12s %-12s %s\n", "graph", "kernels", "size (us)", "combine (ms)", "search (ms)", "checksum");
+    for (auto& path : paths) {
+        graph_t* g = graph_read_dimacs_file(const_cast<char*>(path.c_str()));
+        if (!g) {
+            fprintf(stderr, "Cannot read %s\n", path.c_str());
+            return 1;
+        }
+        string name = path.substr(path.find_last_of('/') + 1);
+        double scalar[3] = { 0, 0, 0 };
+        for (auto kernels = set_kernels_all; *kernels; ++kernels) {
+            if (!set_kernels_select((*kernels)->name))
+                continue;
+            // Keeps the timed calls from being optimized away.
+            volatile unsigned long sink;
+            double seconds[3] = {
+                TimePerRun([&]() { sink = SizeRows(g); }),
+                TimePerRun([&]() { sink = CombineRows(g); }),
+                TimePerRun([&]() { sink = SearchClique(g); }),
+            };
+            unsigned long checksum = SizeRows(g) + CombineRows(g) + SearchClique(g);
+            if (kernels == set_kernels_all)
+                std::copy(seconds, seconds + 3, scalar);
+            printf("%-20s %-8s %5.1f %4.2fx %6.2f %4.2fx %6.2f %4.2fx %lu\n", name.c_str(), (*kernels)->name,
+                seconds[0] * 1e6, scalar[0] / seconds[0], seconds[1] * 1e3, scalar[1] / seconds[1],
+                seconds[2] * 1e3, scalar[2] / seconds[2], checksum);
+        }
+        graph_free(g);
+    }
+    set_kernels_select(NULL);
+    return 0;
+}
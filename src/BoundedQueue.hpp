@@ -0,0 +1,48 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+
+// A blocking FIFO queue holding at most `capacity` items, for handing work
+// from one thread to another. Close() wakes up both sides: Push then fails
+// and Pop drains the remaining items before failing.
+template<class T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity_(capacity), closed_(false) {}
+
+    bool Push(T&& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [&]() { return closed_ || items_.size() < capacity_; });
+        if (closed_)
+            return false;
+        items_.push(std::move(item));
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    bool Pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [&]() { return closed_ || !items_.empty(); });
+        if (items_.empty())
+            return false;
+        item = std::move(items_.front());
+        items_.pop();
+        notFull_.notify_one();
+        return true;
+    }
+
+    void Close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        notFull_.notify_all();
+        notEmpty_.notify_all();
+    }
+private:
+    size_t capacity_;
+    bool closed_;
+    queue<T> items_;
+    std::mutex mutex_;
+    std::condition_variable notFull_;
+    std::condition_variable notEmpty_;
+};
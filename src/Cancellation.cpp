@@ -0,0 +1,71 @@
+#include "Pch.hpp"
+#include "Cancellation.hpp"
+
+#include <csignal>
+
+string CancellationToken::Cause() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cause_;
+}
+
+void CancellationToken::Cancel(string cause) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!cancelled_) {
+        cause_ = cause;
+        cancelled_ = true;
+    }
+    for (auto ctx : contexts_)
+        ctx->interrupt();
+}
+
+void CancellationToken::Register(context& ctx) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    contexts_.push_back(&ctx);
+    if (cancelled_)
+        ctx.interrupt();
+}
+
+void CancellationToken::Unregister(context& ctx) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    contexts_.erase(std::remove(contexts_.begin(), contexts_.end(), &ctx), contexts_.end());
+}
+
+// How often the watchdog looks at the clock and the signal flag.
+static const std::chrono::milliseconds WatchdogPeriod(10);
+
+static volatile std::sig_atomic_t interruptReceived = 0;
+
+static void OnInterrupt(int) {
+    interruptReceived = 1;
+    std::signal(SIGINT, SIG_DFL);
+}
+
+Watchdog::Watchdog(CancellationToken& token, double seconds) : token_(token), stopping_(false) {
+    std::signal(SIGINT, OnInterrupt);
+    thread_ = std::thread([this, seconds]() { Run(seconds); });
+}
+
+Watchdog::~Watchdog() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    stop_.notify_one();
+    thread_.join();
+    std::signal(SIGINT, SIG_DFL);
+}
+
+void Watchdog::Run(double seconds) {
+    using Clock = std::chrono::steady_clock;
+    auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_.wait_for(lock, WatchdogPeriod, [&]() { return stopping_; })) {
+        if (interruptReceived)
+            token_.Cancel("interrupted");
+        else if (seconds > 0 && Clock::now() >= deadline)
+            token_.Cancel("deadline reached");
+        else if (token_.IsCancelled())
+            token_.Cancel("");
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <condition_variable>
+
+// Shared stop flag for every long running loop of a run. Cancelling also
+// interrupts the Z3 contexts registered with the token, so that checks in
+// progress return unknown.
+class CancellationToken {
+public:
+    CancellationToken() : cancelled_(false) {}
+
+    bool IsCancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+    // Why the run was cancelled, or empty if it was not.
+    string Cause();
+
+    // Sets the flag and interrupts all registered contexts. May be called
+    // repeatedly; only the first cause is kept.
+    void Cancel(string cause);
+
+    void Register(context& ctx);
+    void Unregister(context& ctx);
+private:
+    std::atomic<bool> cancelled_;
+    std::mutex mutex_;
+    string cause_;
+    vector<context*> contexts_;
+};
+
+// Keeps ctx registered with a token for the lifetime of the scope.
+class CancellationScope {
+public:
+    CancellationScope(CancellationToken& token, context& ctx) : token_(token), ctx_(ctx) { token_.Register(ctx_); }
+    ~CancellationScope() { token_.Unregister(ctx_); }
+
+    CancellationScope(const CancellationScope&) = delete;
+    CancellationScope& operator=(const CancellationScope&) = delete;
+private:
+    CancellationToken& token_;
+    context& ctx_;
+};
+
+// Cancels a token once `seconds` have passed (0 means never) or SIGINT
+// arrives. A check started just after an interrupt would miss it, so from
+// then on the watchdog keeps cancelling until it is destroyed. A second
+// SIGINT kills the process as usual.
+class Watchdog {
+public:
+    Watchdog(CancellationToken& token, double seconds);
+    ~Watchdog();
+
+    Watchdog(const Watchdog&) = delete;
+    Watchdog& operator=(const Watchdog&) = delete;
+private:
+    void Run(double seconds);
+
+    CancellationToken& token_;
+    std::mutex mutex_;
+    std::condition_variable stop_;
+    bool stopping_;
+    std::thread thread_;
+};
@@ -0,0 +1,76 @@
+#include "Pch.hpp"
+#include "CausalIndex.hpp"
+#include "Parallel.hpp"
+
+// Levels with fewer events than this are not worth handing to threads.
+static const size_t MinParallelLevel = 256;
+
+// dst |= src over whole words; written so that the compiler vectorizes it.
+static void OrInto(setelement* __restrict dst, const setelement* __restrict src, size_t words) {
+    for (size_t i = 0; i < words; ++i)
+        dst[i] |= src[i];
+}
+
+bool CausalIndex::Intersect(set_t a, set_t b) const {
+    // Blocks of four words are combined before branching to keep the loop vectorizable.
+    size_t i = 0;
+    for (; i + 4 <= words_; i += 4) {
+        setelement common = (a[i] & b[i]) | (a[i + 1] & b[i + 1]) | (a[i + 2] & b[i + 2]) | (a[i + 3] & b[i + 3]);
+        if (common)
+            return true;
+    }
+    for (; i < words_; ++i)
+        if (a[i] & b[i])
+            return true;
+    return false;
+}
+
+CausalIndex::CausalIndex(const EventStructure& events, unsigned threads) :
+        words_((events.size() + ELEMENTSIZE - 1) / ELEMENTSIZE), stride_(words_ + 1),
+        past_(events.size() * stride_, 0), conflicts_(events.size() * stride_, 0),
+        consistent_(events.size(), 0) {
+    unsigned n = events.size();
+    for (unsigned i = 0; i < n; ++i) {
+        past_[i * stride_] = n;
+        conflicts_[i * stride_] = n;
+    }
+
+    // Group events by the length of the longest causal chain below them.
+    vector<unsigned> depth(n, 0);
+    unsigned maxDepth = 0;
+    for (auto event : events.topologicalOrder()) {
+        for (auto pred : events.predecessors(event))
+            depth[event] = std::max(depth[event], depth[pred] + 1);
+        maxDepth = std::max(maxDepth, depth[event]);
+    }
+    vector<unsigned> levelOffsets(maxDepth + 2, 0);
+    for (unsigned i = 0; i < n; ++i)
+        ++levelOffsets[depth[i] + 1];
+    for (unsigned d = 0; d <= maxDepth; ++d)
+        levelOffsets[d + 1] += levelOffsets[d];
+    vector<unsigned> byLevel(n);
+    vector<unsigned> fill(begin(levelOffsets), end(levelOffsets) - 1);
+    for (unsigned i = 0; i < n; ++i)
+        byLevel[fill[depth[i]]++] = i;
+
+    auto compute = [&](unsigned event) {
+        set_t past = this->past(event);
+        set_t conflicts = this->conflicts(event);
+        SET_ADD_ELEMENT(past, event);
+        for (auto pred : events.predecessors(event)) {
+            OrInto(past, this->past(pred), words_);
+            OrInto(conflicts, this->conflicts(pred), words_);
+        }
+        for (auto conflict : events.conflicts(event))
+            SET_ADD_ELEMENT(conflicts, conflict);
+        consistent_[event] = !Intersect(conflicts, past);
+    };
+
+    for (unsigned d = 0; d <= maxDepth; ++d) {
+        unsigned first = levelOffsets[d];
+        unsigned count = levelOffsets[d + 1] - first;
+        ParallelFor(count, count < MinParallelLevel ? 1 : threads, [&](size_t k) {
+            compute(byLevel[first + k]);
+        });
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "EventStructure.hpp"
+#include "cliquer.h"
+
+// Per-event bitsets over all events of a structure: the causal past of each
+// event (including itself) and the events in immediate conflict with some
+// event of that past. Event a has an inherited conflict with event b iff
+// conflicts(a) intersects past(b), so compatibility of two events is a single
+// intersection test.
+//
+// Rows are stored back to back in one block, each preceded by the size word
+// Cliquer expects, so every row is a valid set_t. Memory is quadratic in the
+// number of events.
+class CausalIndex {
+public:
+    // Builds the rows in topological order. Events of equal depth form an
+    // antichain and are computed on up to `threads` threads.
+    CausalIndex(const EventStructure& events, unsigned threads = 1);
+
+    set_t past(unsigned event) const { return row(past_, event); }
+    set_t conflicts(unsigned event) const { return row(conflicts_, event); }
+
+    // Whether the event can occur at all, i.e. its past is conflict free.
+    bool isConsistent(unsigned event) const { return consistent_[event] != 0; }
+    bool AreCompatible(unsigned a, unsigned b) const {
+        return consistent_[a] && consistent_[b] && !Intersect(conflicts(a), past(b));
+    }
+
+    size_t words() const { return words_; }
+    bool Intersect(set_t a, set_t b) const;
+private:
+    set_t row(const vector<setelement>& rows, unsigned event) const {
+        return const_cast<setelement*>(&rows[event * stride_ + 1]);
+    }
+
+    size_t words_;
+    size_t stride_;
+    vector<setelement> past_;
+    vector<setelement> conflicts_;
+    vector<unsigned char> consistent_;
+};
@@ -0,0 +1,148 @@
+#include "Pch.hpp"
+#include "Checkpoint.hpp"
+#include "SeddEcException.hpp"
+
+#include <cstdio>
+
+static const char Magic[] = "SEDDEC-CHECKPOINT";
+static const unsigned Version = 1;
+
+void WriteCheckpoint(string path, const vector<string>& events, const graph_t* graph, const vector<vector<unsigned>>& tests) {
+    string temporary = path + ".tmp";
+    std::ofstream out(temporary, std::ios::trunc);
+    out << Magic << ' ' << Version << '\n';
+
+    out << "events " << events.size() << '\n';
+    for (auto& name : events)
+        out << name << '\n';
+
+    out << "graph " << (graph ? 1 : 0) << '\n';
+    if (graph) {
+        out << std::hex;
+        for (int i = 0; i < graph->n; ++i) {
+            // Words past the last one with a neighbour below i are left out.
+            int words = 0;
+            for (int w = 0; w * ELEMENTSIZE < i; ++w) {
+                setelement word = graph->edges[i][w];
+                if ((w + 1) * ELEMENTSIZE > i)
+                    word &= SET_BIT_MASK(i % ELEMENTSIZE) - 1;
+                if (word != 0)
+                    words = w + 1;
+            }
+            for (int w = 0; w < words; ++w) {
+                setelement word = graph->edges[i][w];
+                if ((w + 1) * ELEMENTSIZE > i)
+                    word &= SET_BIT_MASK(i % ELEMENTSIZE) - 1;
+                out << (w ? " " : "") << word;
+            }
+            out << '\n';
+        }
+        out << std::dec;
+    }
+
+    out << "tests " << tests.size() << '\n';
+    for (auto& test : tests) {
+        for (size_t k = 0; k < test.size(); ++k)
+            out << (k ? " " : "") << test[k];
+        out << '\n';
+    }
+
+    out.close();
+    if (!out || std::rename(temporary.c_str(), path.c_str()) != 0)
+        throw SeddEcException(Reason::IO_ERROR, FORMAT("Cannot write " << path));
+}
+
+static void ExpectHeader(std::istream& in, string keyword, size_t& count, string path) {
+    string word;
+    if (!(in >> word >> count) || word != keyword)
+        throw SeddEcException(Reason::INVALID_INPUT_FORMAT, FORMAT("Expected " << keyword << " in checkpoint " << path));
+    in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+}
+
+Checkpoint ReadCheckpoint(string path, const vector<string>& events) {
+    std::ifstream in(path);
+    if (!in)
+        throw SeddEcException(Reason::IO_ERROR, FORMAT("Cannot open " << path));
+
+    size_t version;
+    ExpectHeader(in, Magic, version, path);
+    if (version != Version)
+        throw SeddEcException(Reason::UNSUPPORTED_INPUT, FORMAT("Checkpoint version " << version << " in " << path));
+
+    unordered_map<string, unsigned> indices;
+    for (unsigned i = 0; i < events.size(); ++i)
+        indices.emplace(events[i], i);
+
+    size_t count;
+    ExpectHeader(in, "events", count, path);
+    if (count != events.size())
+        throw SeddEcException(Reason::INVALID_INPUT_FORMAT, FORMAT("Checkpoint " << path << " has " << count << " events, the input " << events.size()));
+    // Index in the checkpoint to index in events.
+    vector<unsigned> renumber(count);
+    string line;
+    for (size_t i = 0; i < count; ++i) {
+        std::getline(in, line);
+        auto index = indices.find(line);
+        if (index == indices.end())
+            throw SeddEcException(Reason::INVALID_INPUT_FORMAT, FORMAT("Checkpoint " << path << " names event " << line << " not in the input"));
+        renumber[i] = index->second;
+    }
+
+    Checkpoint checkpoint;
+    size_t hasGraph;
+    ExpectHeader(in, "graph", hasGraph, path);
+    if (hasGraph) {
+        checkpoint.graph = graph_new(count);
+        for (size_t i = 0; i < count; ++i) {
+            std::getline(in, line);
+            std::istringstream row(line);
+            setelement word;
+            for (size_t w = 0; row >> std::hex >> word; ++w) {
+                for (; word != 0; word &= word - 1) {
+                    size_t j = w * ELEMENTSIZE + __builtin_ctzl(word);
+                    if (j >= i) {
+                        graph_free(checkpoint.graph);
+                        throw SeddEcException(Reason::INVALID_INPUT_FORMAT, FORMAT("Corrupt graph row in checkpoint " << path));
+                    }
+                    GRAPH_ADD_EDGE(checkpoint.graph, renumber[i], renumber[j]);
+                }
+            }
+        }
+    }
+
+    ExpectHeader(in, "tests", count, path);
+    checkpoint.tests.resize(count);
+    for (auto& test : checkpoint.tests) {
+        std::getline(in, line);
+        std::istringstream row(line);
+        unsigned event;
+        while (row >> event) {
+            if (event >= renumber.size()) {
+                if (checkpoint.graph)
+                    graph_free(checkpoint.graph);
+                throw SeddEcException(Reason::INVALID_INPUT_FORMAT, FORMAT("Corrupt test in checkpoint " << path));
+            }
+            test.push_back(renumber[event]);
+        }
+    }
+    if (!in) {
+        if (checkpoint.graph)
+            graph_free(checkpoint.graph);
+        throw SeddEcException(Reason::INVALID_INPUT_FORMAT, FORMAT("Truncated checkpoint " << path));
+    }
+
+    return checkpoint;
+}
+
+Checkpointer::Checkpointer(string path, vector<string> events, double interval)
+    : path_(path), events_(std::move(events)), interval_(interval), lastSave_(Clock::now()) {}
+
+void Checkpointer::Save(const graph_t* graph, const vector<vector<unsigned>>& tests, bool force) {
+    if (path_.empty())
+        return;
+    auto now = Clock::now();
+    if (!force && std::chrono::duration<double>(now - lastSave_).count() < interval_)
+        return;
+    WriteCheckpoint(path_, events_, graph, tests);
+    lastSave_ = now;
+}
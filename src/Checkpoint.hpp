@@ -0,0 +1,48 @@
+#pragma once
+
+#include "cliquer.h"
+
+// Resumable state of a cover run: the compatibility graph if that phase has
+// finished, and the tests found so far as event indices. The events still to
+// cover are those in no test. Events are identified by name on disk, so a run
+// can be resumed against a fresh encoding of the same input.
+//
+// Text layout:
+//
+//   SEDDEC-CHECKPOINT 1
+//   events <n>         followed by one event name per line
+//   graph <0 or 1>     if 1, followed by one line per vertex i holding the
+//                      hex words of its row below the diagonal
+//   tests <count>      followed by one line of event indices per test
+struct Checkpoint {
+    Checkpoint() : graph(nullptr) {}
+
+    // Owned by whoever reads the checkpoint.
+    graph_t* graph;
+    vector<vector<unsigned>> tests;
+};
+
+// Replaces path atomically, so an interrupted write leaves the previous
+// checkpoint intact. graph may be null.
+void WriteCheckpoint(string path, const vector<string>& events, const graph_t* graph, const vector<vector<unsigned>>& tests);
+
+// Reads a checkpoint with its events renumbered to their index in events,
+// which must name the same events in any order.
+Checkpoint ReadCheckpoint(string path, const vector<string>& events);
+
+// Writes the checkpoints of one run, at most once per interval unless forced.
+// A default constructed Checkpointer writes nothing.
+class Checkpointer {
+public:
+    Checkpointer() : interval_(0) {}
+    Checkpointer(string path, vector<string> events, double interval);
+
+    void Save(const graph_t* graph, const vector<vector<unsigned>>& tests, bool force = false);
+private:
+    using Clock = std::chrono::steady_clock;
+
+    string path_;
+    vector<string> events_;
+    double interval_;
+    Clock::time_point lastSave_;
+};
@@ -4,13 +4,27 @@
 #include "SeddEcException.hpp"
 #include "Z3Utils.hpp"
 #include "ESParser.hpp"
+#include "EventStructure.hpp"
+#include "ESBinary.hpp"
+#include "Parallel.hpp"
+#include "Cograph.hpp"
+#include "Cancellation.hpp"
+#include "Checkpoint.hpp"
 
 #include "cliquer.h"
 
 using ExprSet = unordered_set<expr, Z3Hash, Z3Eq>;
+using ExprMap = unordered_map<expr, expr, Z3Hash, Z3Eq>;
 
 static const double OptimizeTimeout = 10;
 
+// Progress output is turned off in batch mode, where many inputs run at once.
+static bool showProgress = true;
+
+// Raised by the deadline or SIGINT. Every phase then stops and the cover is
+// finished with a test for each event left uncovered.
+static CancellationToken cancellation;
+
 class Timer {
     using Clock = std::chrono::steady_clock;
     using Second = std::chrono::duration<double, std::ratio<1>>;
@@ -37,8 +51,49 @@ void PrintTotalTime() {
     cout << "Total time: " << totalTimer.elapsed() << "s\n";
 }
 
-ExprSet GetEventVars(expr term) {
-    ExprSet vars;
+// Writes each test of a cover to a file or pipe as soon as it is accepted,
+// one line of event names per test, so that running the tests can overlap
+// with finding them. A default constructed TestStream writes nothing, but
+// like any other it counts the tests passed to it and what they cover.
+class TestStream {
+public:
+    TestStream() {}
+    TestStream(string path, vector<string> events) : out_(new std::ofstream(path)), events_(std::move(events)) {
+        if (!*out_)
+            throw SeddEcException(Reason::IO_ERROR, FORMAT("Cannot write " << path));
+    }
+
+    void Write(const vector<unsigned>& test) {
+        ++count_;
+        for (auto event : test) {
+            if (event >= covered_.size())
+                covered_.resize(event + 1);
+            covered_[event] = true;
+        }
+        if (!out_)
+            return;
+        for (size_t k = 0; k < test.size(); ++k)
+            *out_ << (k ? " " : "") << events_[test[k]];
+        *out_ << std::endl;
+    }
+
+    // Completes the cover of events 0..eventCount-1 with a test of its own for
+    // each event no test so far covers. Returns the number of tests in it.
+    size_t CoverRest(unsigned eventCount) {
+        for (unsigned event = 0; event < eventCount; ++event)
+            if (event >= covered_.size() || !covered_[event])
+                Write({ event });
+        return count_;
+    }
+private:
+    std::unique_ptr<std::ofstream> out_;
+    vector<string> events_;
+    size_t count_ = 0;
+    vector<bool> covered_;
+};
+
+vector<expr> GetEventVars(expr term) {
+    vector<expr> vars;
     ExprSet seen;
     queue<expr> work;
     work.push(term);
@@ -53,7 +108,7 @@ ExprSet GetEventVars(expr term) {
         if (current.is_const()) {
             symbol name = current.decl().name();
             if (name.kind() == Z3_STRING_SYMBOL && name.str().find("el") == 0)
-                vars.insert(current);
+                vars.push_back(current);
         }
         else if (current.is_app()) {
             unsigned num = current.num_args();
@@ -64,112 +119,413 @@ ExprSet GetEventVars(expr term) {
         else if (current.is_quantifier()) {
             work.push(current.body());
         }
-        else {
-            cerr << "unsupported: " << current << "\n";
-            exit(1);
-        }
+        else
+            throw SeddEcException(Reason::UNSUPPORTED_INPUT, FORMAT("unsupported: " << current));
     }
 
     return vars;
 }
 
-vector<vector<expr>> Optimize(context& ctx, expr encoding, ExprSet eventVars) {
-    vector<vector<expr>> tests;
+// Collects the uninterpreted constants term mentions.
+ExprSet GetConstants(expr term) {
+    ExprSet constants;
+    ExprSet seen;
+    queue<expr> work;
+    work.push(term);
+
+    while (!work.empty()) {
+        expr current = work.front();
+        work.pop();
+        if (seen.find(current) != end(seen))
+            continue;
+        seen.insert(current);
+
+        if (current.is_const()) {
+            if (current.decl().decl_kind() == Z3_OP_UNINTERPRETED)
+                constants.insert(current);
+        }
+        else if (current.is_app()) {
+            unsigned num = current.num_args();
+            for (unsigned i = 0; i < num; i++) {
+                work.push(current.arg(i));
+            }
+        }
+        else if (current.is_quantifier()) {
+            work.push(current.body());
+        }
+    }
+
+    return constants;
+}
+
+// Counts for each of vars how many distinct subterms of term use it directly.
+vector<unsigned> CountOccurrences(expr term, const vector<expr>& vars) {
+    unordered_map<expr, unsigned, Z3Hash, Z3Eq> varIndex;
+    for (unsigned i = 0; i < vars.size(); ++i)
+        varIndex.emplace(vars[i], i);
+    vector<unsigned> counts(vars.size());
+    ExprSet seen;
+    queue<expr> work;
+    work.push(term);
+
+    while (!work.empty()) {
+        expr current = work.front();
+        work.pop();
+        if (seen.find(current) != end(seen))
+            continue;
+        seen.insert(current);
+
+        if (current.is_app()) {
+            unsigned num = current.num_args();
+            for (unsigned i = 0; i < num; i++) {
+                auto var = varIndex.find(current.arg(i));
+                if (var != end(varIndex))
+                    ++counts[var->second];
+                work.push(current.arg(i));
+            }
+        }
+        else if (current.is_quantifier()) {
+            work.push(current.body());
+        }
+    }
+
+    return counts;
+}
+
+// The MaxSAT problem Optimize solves, in the context of its encoding. Each
+// check solves testsPerRound copies of the encoding at once, which share the
+// objective of covering new events, and so yields up to that many tests.
+// Every event variable gets one soft gain literal for the whole run, which
+// can only be true when some test contains the event. Retiring a covered
+// event asserts the negation of its gain, so it stops counting. Nothing is
+// ever popped and the solver keeps what it has learned.
+class CoverProblem {
+    context& ctx_;
+    vector<vector<expr>> copies_;
+    // Copy c of variable i has index c * variable count + i.
+    ConstIndex index_;
+    vector<expr> gains_;
+    optimize opt_;
+
+public:
+    // Different strategies add the soft constraints in a different order and
+    // tune the MaxSAT engine differently, so that portfolio members do not
+    // all search the same way.
+    CoverProblem(expr encoding, const vector<expr>& vars, unsigned testsPerRound, unsigned strategy)
+        : ctx_(encoding.ctx()), copies_{ vars }, opt_{ encoding.ctx() } {
+        // Copy 0 is the encoding itself; the others rename all its constants.
+        opt_.add(encoding);
+        if (testsPerRound > 1) {
+            expr_vector from{ ctx_ };
+            for (auto constant : GetConstants(encoding))
+                from.push_back(constant);
+            for (unsigned c = 1; c < testsPerRound; ++c) {
+                expr_vector to{ ctx_ };
+                ExprMap renamed;
+                for (unsigned i = 0; i < from.size(); ++i) {
+                    expr fresh{ ctx_, Z3_mk_fresh_const(ctx_, from[i].decl().name().str().c_str(), from[i].get_sort()) };
+                    to.push_back(fresh);
+                    renamed.emplace(from[i], fresh);
+                }
+                opt_.add(encoding.substitute(from, to));
+                copies_.emplace_back();
+                for (auto& var : vars)
+                    copies_.back().push_back(renamed.at(var));
+            }
+        }
+
+        vector<expr> allCopies;
+        for (auto& copy : copies_)
+            allCopies.insert(allCopies.end(), copy.begin(), copy.end());
+        index_ = ConstIndex(allCopies);
+
+        for (unsigned i = 0; i < vars.size(); ++i) {
+            expr gain{ ctx_, Z3_mk_fresh_const(ctx_, "gain", ctx_.bool_sort()) };
+            gains_.push_back(gain);
+            expr_vector occurrences{ ctx_ };
+            for (auto& copy : copies_)
+                occurrences.push_back(copy[i]);
+            opt_.add(implies(gain, MkOr(occurrences)));
+        }
+
+        vector<unsigned> order(vars.size());
+        for (unsigned i = 0; i < order.size(); ++i)
+            order[i] = i;
+        if (strategy > 0)
+            std::shuffle(order.begin(), order.end(), std::mt19937(strategy));
+        for (auto i : order)
+            opt_.add(gains_[i], 1);
+
+        params p{ ctx_ };
+        // SIGINT is handled by the watchdog, not by Z3.
+        p.set("ctrl_c", false);
+        switch (strategy % 4) {
+        case 1:
+            p.set("maxsat_engine", ctx_.str_symbol("pd-maxres"));
+            break;
+        case 2:
+            p.set("maxres.hill_climb", false);
+            break;
+        case 3:
+            p.set("maxres.maximize_assignment", true);
+            break;
+        }
+        opt_.set(p);
+    }
+
+    // Looks for the best round whose first test contains event variable
+    // `first` and that agrees with cube, pairs of an event variable and its
+    // value. Returns unknown if the timeout (in milliseconds) runs out or
+    // the check is interrupted.
+    check_result Check(unsigned first, unsigned timeout, const vector<pair<unsigned, bool>>& cube = {}) {
+        params p{ ctx_ };
+        p.set(":timeout", timeout);
+        opt_.set(p);
+
+        // Like hard constraints, but without leaving a scope to pop.
+        expr_vector assumptions{ ctx_ };
+        assumptions.push_back(copies_[0][first]);
+        for (auto& literal : cube)
+            assumptions.push_back(literal.second ? copies_[0][literal.first] : !copies_[0][literal.first]);
+        try {
+            return opt_.check(assumptions);
+        } catch (z3::exception e) {
+            if (e.msg() != string("canceled"))
+                throw e;
+            return unknown;
+        }
+    }
+
+    // Reads the tests of the last check as indices of event variables, or
+    // returns false if it left no model.
+    bool GetTests(vector<vector<unsigned>>& tests) {
+        try {
+            auto model = opt_.get_model();
+            unsigned count = copies_[0].size();
+            tests.assign(copies_.size(), {});
+            index_.ForEachTrue(model, [&](unsigned i) {
+                tests[i / count].push_back(i % count);
+            });
+            return true;
+        } catch (z3::exception) {
+            return false;
+        }
+    }
+
+    void Retire(unsigned i) {
+        opt_.add(!gains_[i]);
+    }
+
+    // Stops a check running on another thread.
+    void Interrupt() {
+        ctx_.interrupt();
+    }
+};
+
+// Each round is split into 2^cubeDepth cubes, so deeper splits are rejected.
+static const unsigned MaxCubeDepth = 16;
+
+// Finds tests with MaxSAT on up to `threads` threads, each with a translated
+// copy of the problem in a context of its own. With cubeDepth 0 the threads
+// form a portfolio: every round runs on all of them with different
+// strategies, the first to finish wins and the others are interrupted.
+// Otherwise each round is split on the cubeDepth uncovered event variables
+// that occur most often in the encoding, the resulting cubes are shared out
+// between the threads and the round covering the most events wins. Tests
+// are returned as indices into vars, starting with those in resumed, and
+// written to testStream as they are accepted.
+vector<vector<unsigned>> Optimize(expr encoding, const vector<expr>& vars, unsigned testsPerRound, unsigned threads, unsigned cubeDepth,
+                                  const vector<vector<unsigned>>& resumed, Checkpointer& checkpointer, TestStream& testStream) {
+    vector<vector<unsigned>> tests;
 
     unsigned timeout = 2000;
 
-    ExprSet toCover = eventVars;
+    // Events are identified by their index in vars from here on.
+    set_t isCovered = set_new(std::max<size_t>(vars.size(), 1));
+    size_t missing = vars.size();
+    // No event before this one is uncovered.
+    unsigned firstUncovered = 0;
 
     int percent = 0;
 
     auto status = [&]() {
-        auto total = eventVars.size();
-        auto missing = toCover.size();
+        auto total = vars.size();
 
         int newPercent = (total - missing) * 100.0 / total;
-        if (newPercent != percent) {
+        if (newPercent != percent && showProgress) {
             cout << "Tests: " << tests.size() << "\tCovered: " << (total - missing) << "/" << total << "\tProgress: " << newPercent << "%\t";
             cout << GetETA(newPercent / 100.0) << std::endl;
         }
         percent = newPercent;
     };
 
-    auto addTest = [&](const model& model) {
-        vector<expr> test;
-        for (auto var : eventVars)
-            if (eq(model.eval(var), ctx.bool_val(true)))
-                test.push_back(var);
-        size_t covered = 0;
-        for (auto var : test)
-            covered += toCover.erase(var);
-
-        if (covered > 0)
-            tests.emplace_back(std::move(test));
-        return covered != 0;
-    };
+    vector<std::unique_ptr<context>> contexts;
+    vector<std::unique_ptr<CoverProblem>> problems;
+    vector<std::unique_ptr<CancellationScope>> scopes;
+    problems.emplace_back(new CoverProblem(encoding, vars, testsPerRound, 0));
+    for (unsigned member = 1; member < ThreadCount(threads); ++member) {
+        contexts.emplace_back(new context);
+        scopes.emplace_back(new CancellationScope(cancellation, *contexts.back()));
+        vector<expr> translated;
+        for (auto& var : vars)
+            translated.push_back(Translate(var, *contexts.back()));
+        problems.emplace_back(new CoverProblem(Translate(encoding, *contexts.back()), translated, testsPerRound, member));
+    }
 
-    auto countCovered = [&](const model& model) {
-        unsigned count = 0;
-        for (auto var : toCover)
-            if (eq(model.eval(var), ctx.bool_val(true)))
-                ++count;
-        return count;
+    vector<unsigned> occurrences;
+    if (cubeDepth > 0)
+        occurrences = CountOccurrences(encoding, vars);
+
+    // Adds the tests of one round that cover something new.
+    auto addTests = [&](const vector<vector<unsigned>>& round) {
+        bool progress = false;
+        for (auto& test : round) {
+            size_t covered = 0;
+            for (auto i : test) {
+                if (!SET_CONTAINS_FAST(isCovered, i)) {
+                    SET_ADD_ELEMENT(isCovered, i);
+                    for (auto& problem : problems)
+                        problem->Retire(i);
+                    ++covered;
+                }
+            }
+            if (covered > 0) {
+                missing -= covered;
+                tests.push_back(test);
+                testStream.Write(test);
+                progress = true;
+            }
+        }
+        return progress;
     };
-    
+
+    addTests(resumed);
     status();
 
     unsigned optTimeout = 0; --optTimeout;
-    optimize opt{ ctx };
-    opt.add(encoding);
-    params p{ ctx };
-    while (!toCover.empty()) {
-        opt.push();
-
-        p.set(":timeout", optTimeout);
-        opt.set(p);
-
-        bool first = true;
-        for (auto var : toCover) {
-            if (first) {
-                opt.add(var);
-                first = false;
+    while (missing > 0 && !cancellation.IsCancelled()) {
+        // The first uncovered event must be in the first test of the round.
+        while (SET_CONTAINS_FAST(isCovered, firstUncovered))
+            ++firstUncovered;
+        unsigned first = firstUncovered;
+        check_result result = unknown;
+        vector<vector<unsigned>> round;
+        bool hasModel = false;
+
+        if (cubeDepth > 0) {
+            vector<unsigned> split;
+            for (unsigned i = first + 1; i < vars.size(); ++i)
+                if (!SET_CONTAINS_FAST(isCovered, i))
+                    split.push_back(i);
+            std::sort(split.begin(), split.end(), [&](unsigned a, unsigned b) {
+                return occurrences[a] != occurrences[b] ? occurrences[a] > occurrences[b] : a < b;
+            });
+            split.resize(std::min<size_t>(split.size(), cubeDepth));
+
+            size_t cubeCount = size_t(1) << split.size();
+            vector<check_result> results(cubeCount, unknown);
+            vector<vector<vector<unsigned>>> rounds(cubeCount);
+            vector<char> hasModels(cubeCount, false);
+            ParallelFor(cubeCount, problems.size(), [&](unsigned worker, size_t index) {
+                vector<pair<unsigned, bool>> cube;
+                for (unsigned bit = 0; bit < split.size(); ++bit)
+                    cube.emplace_back(split[bit], (index >> bit & 1) != 0);
+                results[index] = problems[worker]->Check(first, optTimeout, cube);
+                hasModels[index] = problems[worker]->GetTests(rounds[index]);
+            });
+
+            // A round is unsat only if every cube is. Otherwise the cube whose
+            // model covers the most wins, preferring cubes that finished.
+            bool anyUnknown = false;
+            bool bestFinished = false;
+            size_t bestCovered = 0;
+            for (size_t index = 0; index < cubeCount; ++index) {
+                if (results[index] == unsat)
+                    continue;
+                anyUnknown |= results[index] != sat;
+                if (!hasModels[index])
+                    continue;
+                set_t gained = set_copy(nullptr, isCovered);
+                size_t covered = 0;
+                for (auto& test : rounds[index]) {
+                    for (auto i : test) {
+                        if (!SET_CONTAINS_FAST(gained, i)) {
+                            SET_ADD_ELEMENT(gained, i);
+                            ++covered;
+                        }
+                    }
+                }
+                set_free(gained);
+                bool finished = results[index] == sat;
+                if (!hasModel || finished > bestFinished || (finished == bestFinished && covered > bestCovered)) {
+                    round = rounds[index];
+                    hasModel = true;
+                    bestFinished = finished;
+                    bestCovered = covered;
+                }
             }
-            else
-                opt.add(var, 1);
+            result = bestFinished ? sat : anyUnknown ? unknown : unsat;
+        } else if (problems.size() == 1) {
+            result = problems[0]->Check(first, optTimeout);
+            hasModel = problems[0]->GetTests(round);
+        } else {
+            std::atomic<int> winner{ -1 };
+            std::atomic<unsigned> running{ (unsigned)problems.size() };
+            ParallelFor(problems.size(), problems.size(), [&](size_t member) {
+                check_result memberResult = unknown;
+                if (winner < 0)
+                    memberResult = problems[member]->Check(first, optTimeout);
+                int none = -1;
+                if (!winner.compare_exchange_strong(none, member)) {
+                    --running;
+                    return;
+                }
+                result = memberResult;
+                hasModel = problems[member]->GetTests(round);
+                --running;
+                // Members may still be about to start their check, so keep
+                // interrupting until all have returned.
+                while (running > 0) {
+                    for (unsigned other = 0; other < problems.size(); ++other)
+                        if (other != member)
+                            problems[other]->Interrupt();
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            });
         }
 
-        try {
-            auto result = opt.check();
-            if (result == unsat) {
-                cerr << "Uncoverable event!?\n";
-                exit(1);
-            } else if (result != sat) {
-                cerr << "==Unknown==\n";
-                optTimeout = optTimeout * 3 / 2;
-            }
-            addTest(opt.get_model());
-        } catch (z3::exception e) {
-            if (e.msg() == string("canceled")) {
+        if (result == unsat) {
+            set_free(isCovered);
+            throw SeddEcException(Reason::UNCOVERABLE_EVENT);
+        }
+        if (result != sat && !cancellation.IsCancelled()) {
+            if (showProgress)
                 cout << "==Timeout==\n";
-                try {
-                    auto model = opt.get_model();
-                    if (!addTest(model))
-                        optTimeout = optTimeout * 3 / 2;
-                } catch (z3::exception) {
-                    cerr << "Timout without solution!\n";
-                    optTimeout = optTimeout * 3 / 2;
-                }
-            } else throw e;
+            if (!hasModel && showProgress)
+                cerr << "Timout without solution!\n";
         }
+        if (!(hasModel && addTests(round)) || result != sat)
+            optTimeout = optTimeout * 3 / 2;
 
         status();
-        opt.pop();
+        checkpointer.Save(nullptr, tests);
     }
 
+    checkpointer.Save(nullptr, tests, true);
+
+    // Only left over when cancelled.
+    for (unsigned i = 0; i < vars.size(); ++i)
+        if (!SET_CONTAINS_FAST(isCovered, i)) {
+            tests.push_back({ i });
+            testStream.Write(tests.back());
+        }
+
+    set_free(isCovered);
     return tests;
 }
 
-graph_t* ParseCograph(string path) {
+// Reads a cograph and the ids of its vertices into names.
+graph_t* ParseCograph(string path, vector<string>& names) {
     std::ifstream file(path);
 
     unordered_map<int, int> events;
@@ -181,6 +537,7 @@ graph_t* ParseCograph(string path) {
     int n = 0;
     while (nodes >> id) {
         events.emplace(id, n++);
+        names.push_back(std::to_string(id));
     }
 
     auto graph = graph_new(n);
@@ -200,13 +557,20 @@ graph_t* ParseCograph(string path) {
     return graph;
 }
 
-boolean noTime(int,int,int,int,double,double,clique_options *) { return true; }
+// Lets Cliquer abort between base level vertices once the run is cancelled.
+boolean untilCancelled(int,int,int,int,double,double,clique_options *) { return !cancellation.IsCancelled(); }
 
-unsigned CoverCograph(graph_t* graph) {
-    unsigned tests = 0;
+// Covers the vertices of graph with cliques, continuing from the tests in
+// resumed. Events left in no clique get a test of their own. Covered vertices
+// are isolated as it goes, so the graph and the tests so far can be saved as
+// a checkpoint at any point. Tests are written to testStream as they are
+// accepted. Each clique search runs on the given number of threads.
+unsigned CoverCograph(graph_t* graph, unsigned threads, const vector<vector<unsigned>>& resumed, Checkpointer& checkpointer, TestStream& testStream) {
+    vector<vector<unsigned>> tests;
 
     clique_options options = *clique_default_options;
-    options.time_function = noTime;
+    options.time_function = untilCancelled;
+    options.threads = ThreadCount(threads);
 
     int covered = 0;
     int percent = 0;
@@ -214,20 +578,62 @@ unsigned CoverCograph(graph_t* graph) {
     set_t isCovered = set_new(graph->n);
     set_t emptySet = set_new(graph->n);
 
+    auto addTest = [&](set_t clique) {
+        vector<unsigned> test;
+        int i = -1;
+        while ((i = set_return_next(clique, i)) >= 0)
+            test.push_back(i);
+        testStream.Write(test);
+        tests.emplace_back(std::move(test));
+    };
+
+    auto finish = [&]() {
+        checkpointer.Save(graph, tests, true);
+        for (int i = 0; i < graph->n; ++i)
+            if (!SET_CONTAINS_FAST(isCovered, i))
+                testStream.Write({ (unsigned)i });
+        unsigned count = tests.size() + graph->n - set_size(isCovered);
+        set_free(isCovered);
+        set_free(emptySet);
+        return count;
+    };
+
+    if (!resumed.empty()) {
+        for (auto& test : resumed) {
+            for (auto i : test)
+                SET_ADD_ELEMENT(isCovered, i);
+            tests.push_back(test);
+            testStream.Write(test);
+        }
+        for (int j = 0; j < graph->n; ++j) {
+            if (SET_CONTAINS_FAST(isCovered, j))
+                set_empty(graph->edges[j]);
+            else
+                set_remove(graph->edges[j], isCovered);
+        }
+    }
+
 ADD_TEST:
-    set_t maxClique = clique_unweighted_find_single(graph, 0, 0, false, &options);
+    set_t maxClique = nullptr;
+    if (!cancellation.IsCancelled())
+        maxClique = clique_unweighted_find_single(graph, 0, 0, false, &options);
+
+    // Cancelled: the remaining events get a test each.
+    if (!maxClique)
+        return finish();
 
     if (set_size(maxClique) > 2)
-        ++tests;
+        addTest(maxClique);
     else if (set_size(maxClique) == 2) {
+        set_free(maxClique);
         int j = graph->n - 1;
         for (;;) {
             for (; j >= 0 && set_size(graph->edges[j]) == 0; --j) {}
-            if (j >= 0) {
-                ++tests;
+            if (j >= 0 && !cancellation.IsCancelled()) {
                 set_t clique = set_new(graph->n);
                 SET_ADD_ELEMENT(clique, j);
                 SET_ADD_ELEMENT(clique, set_return_next(graph->edges[j], -1));
+                addTest(clique);
 
                 set_t oldIsCovered = set_duplicate(isCovered);
                 set_union(isCovered, oldIsCovered, clique);
@@ -240,15 +646,12 @@ ADD_TEST:
                     set_union(graph->edges[i], emptySet, emptySet);
                 }
                 set_free(clique);
-            } else {
-                tests += graph->n - set_size(isCovered);
-                set_free(isCovered);
-                set_free(emptySet);
-                return tests;
-            }
+                checkpointer.Save(graph, tests);
+            } else
+                return finish();
             
             int newPercent = set_size(isCovered) * 100.0 / graph->n;
-            if (newPercent != percent) {
+            if (newPercent != percent && showProgress) {
                 cout << "Covered: " << set_size(isCovered) << "/" << graph->n << "\tProgress: " << newPercent << "%\t";
                 cout << GetETA(newPercent / 100.0) << std::endl;
             }
@@ -256,10 +659,8 @@ ADD_TEST:
         }
     }
     else {
-        tests += graph->n - set_size(isCovered);
-        set_free(isCovered);
-        set_free(emptySet);
-        return tests;
+        set_free(maxClique);
+        return finish();
     }
 
     set_t oldIsCovered = set_duplicate(isCovered);
@@ -278,87 +679,412 @@ ADD_TEST:
     }
 
     int newPercent = set_size(isCovered) * 100.0 / graph->n;
-    if (newPercent != percent) {
+    if (newPercent != percent && showProgress) {
         cout << "Covered: " << set_size(isCovered) << "/" << graph->n << "\tProgress: " << newPercent << "%\t";
         cout << GetETA(newPercent / 100.0) << std::endl;
     }
     percent = newPercent;
     set_free(maxClique);
+    checkpointer.Save(graph, tests);
 //    for (int j = 0; j < graph->n; ++j) {
 //        if (graph->weights[j] != 0) goto ADD_TEST;
 //    }
     if (set_size(isCovered) < graph->n) goto ADD_TEST;
 
-    set_free(isCovered);
-    set_free(emptySet);
-    return tests;
+    return finish();
 }
 
-expr EncodeEvents(context& ctx, const vector<Event>& events) {
-    unordered_set<unsigned> leafEvents;
-    for (auto& event : events)
-        leafEvents.emplace(event.id);
-    for (auto& event : events)
-        for (auto& pred : event.predecessors)
-            leafEvents.erase(pred);
-
-    auto eventVar = [&](unsigned id) {
-        return ctx.bool_const(FORMAT((leafEvents.find(id) == leafEvents.end() ? "e" : "el") << id).c_str());
-    };
+expr EventVar(context& ctx, const EventStructure& events, unsigned event) {
+    return ctx.bool_const(FORMAT((events.isLeaf(event) ? "el" : "e") << events.id(event)).c_str());
+}
 
-    expr encoding = ctx.bool_val(true);
-    for (auto& event : events) {
-        auto var = eventVar(event.id);
-        encoding = encoding && (var || !var);
-        for (auto& pred : event.predecessors)
-            encoding = encoding && implies(var, eventVar(pred));
+expr EncodeEvents(context& ctx, const EventStructure& events) {
+    vector<expr> vars;
+    vars.reserve(events.size());
+    for (unsigned i = 0; i < events.size(); ++i)
+        vars.push_back(EventVar(ctx, events, i));
+
+    expr_vector clauses{ ctx };
+    for (unsigned i = 0; i < events.size(); ++i) {
+        auto& var = vars[i];
+        clauses.push_back(var || !var);
+        for (auto pred : events.predecessors(i))
+            clauses.push_back(implies(var, vars[pred]));
+        // Conflicts are symmetric, so each pair is encoded from its lower end.
         expr conflictSet = ctx.bool_val(false);
-        for (auto& conflict : event.conflicts)
-            conflictSet = conflictSet || eventVar(conflict);
-        encoding = encoding && implies(var, !conflictSet);
+        for (auto conflict : events.conflicts(i))
+            if (conflict >= i)
+                conflictSet = conflictSet || vars[conflict];
+        clauses.push_back(implies(var, !conflictSet));
     }
 
-    return encoding;
+    return MkAnd(clauses);
 }
 
-graph_t* SolveCograph(context& ctx, expr encoding, ExprSet eventVars) {
-    auto graph = graph_new(eventVars.size());
+vector<expr> GetEventVars(context& ctx, const EventStructure& events) {
+    vector<expr> vars;
+    for (auto leaf : events.leaves())
+        vars.push_back(EventVar(ctx, events, leaf));
+    return vars;
+}
+
+// Adds an edge between every pair of event variables true in model, since
+// the model is a configuration containing all of them.
+void HarvestEdges(graph_t* graph, const ConstIndex& vars, const model& model) {
+    vector<int> trueVars;
+    vars.ForEachTrue(model, [&](unsigned i) {
+        trueVars.push_back(i);
+    });
+    for (size_t k = 1; k < trueVars.size(); ++k)
+        for (size_t i = 0; i < k; ++i)
+            GRAPH_ADD_EDGE_ATOMIC(graph, trueVars[k], trueVars[i]);
+}
 
+// Interrupted checks may throw instead of returning unknown.
+check_result CheckUnlessCancelled(solver& s, const expr_vector& assumptions) {
+    try {
+        return s.check(assumptions);
+    } catch (z3::exception&) {
+        if (cancellation.IsCancelled())
+            return unknown;
+        throw;
+    }
+}
+
+// A SolveCograph worker's copy of the problem.
+struct CographWorker {
     vector<expr> vars;
-    for (auto var : eventVars)
-        vars.emplace_back(var);
+    ConstIndex index;
+    solver s;
+
+    CographWorker(expr encoding, vector<expr> vars) : vars(std::move(vars)), index(this->vars), s{ encoding.ctx() } {
+        // Prefer true for every atom so that models are large configurations
+        // and each one yields as many edges as possible.
+        params p{ encoding.ctx() };
+        p.set("phase_selection", 1u);
+        p.set("relevancy", 0u);
+        // SIGINT is handled by the watchdog, not by Z3.
+        p.set("ctrl_c", false);
+        s.set(p);
+        s.add(encoding);
+    }
+};
+
+// Rows of the graph are handed out to up to `threads` workers. Z3 contexts
+// are not thread safe, so all but the first worker check a translated copy
+// of the problem in a context of their own, each with one incremental solver.
+graph_t* SolveCograph(expr encoding, const vector<expr>& vars, unsigned threads) {
+    auto graph = graph_new(vars.size());
+
+    unsigned workerCount = std::min<size_t>(ThreadCount(threads), std::max<size_t>(vars.size(), 1));
+    vector<std::unique_ptr<context>> contexts;
+    vector<std::unique_ptr<CographWorker>> workers;
+    workers.emplace_back(new CographWorker(encoding, vars));
+    vector<std::unique_ptr<CancellationScope>> scopes;
+    for (unsigned w = 1; w < workerCount; ++w) {
+        contexts.emplace_back(new context);
+        scopes.emplace_back(new CancellationScope(cancellation, *contexts.back()));
+        vector<expr> translated;
+        for (auto& var : vars)
+            translated.push_back(Translate(var, *contexts.back()));
+        workers.emplace_back(new CographWorker(Translate(encoding, *contexts.back()), translated));
+    }
+
+    std::atomic<int> rowsDone{ 0 };
+    int percent = 0;
+    std::mutex progressMutex;
+
+    ParallelFor(vars.size(), workerCount, [&](unsigned w, size_t row) {
+        auto& vars = workers[w]->vars;
+        auto& index = workers[w]->index;
+        auto& s = workers[w]->s;
+        int current = vars.size() - 1 - row;
+        // Cancelled rows are left with the edges found so far, which are all
+        // real, so the graph stays sound for CoverCograph.
+        if (cancellation.IsCancelled())
+            return;
+
+        expr_vector assumptions{ s.ctx() };
+        assumptions.push_back(vars[current]);
+        // An event that occurs in no configuration has no edges.
+        if (CheckUnlessCancelled(s, assumptions) == sat) {
+            HarvestEdges(graph, index, s.get_model());
+            for (int i = 0; i < current && !cancellation.IsCancelled(); ++i) {
+                if (GRAPH_IS_EDGE_ATOMIC(graph, current, i))
+                    continue;
+                expr_vector pair{ s.ctx() };
+                pair.push_back(vars[current]);
+                pair.push_back(vars[i]);
+                if (CheckUnlessCancelled(s, pair) == sat)
+                    HarvestEdges(graph, index, s.get_model());
+            }
+        }
+
+        int newPercent = (rowsDone += 1) * 100.0 / vars.size();
+        std::lock_guard<std::mutex> lock(progressMutex);
+        if (newPercent > percent && showProgress)
+            cout << newPercent << "%\n";
+        percent = std::max(percent, newPercent);
+    });
+
+    graph_test(graph, showProgress ? stdout : nullptr);
+    return graph;
+}
+
+// Builds the same graph as SolveCograph with one query per event variable:
+// the consequences of assuming it true list every earlier variable that is
+// then forced false, and all the others are compatible with it.
+graph_t* ConsequencesCograph(context& ctx, expr encoding, const vector<expr>& vars) {
+    auto graph = graph_new(vars.size());
+
+    unordered_map<unsigned, int> varIndex;
+    for (unsigned i = 0; i < vars.size(); ++i)
+        varIndex[Z3_get_ast_id(ctx, vars[i])] = i;
 
     solver s{ ctx };
+    // SIGINT is handled by the watchdog, not by Z3.
+    params p{ ctx };
+    p.set("ctrl_c", false);
+    s.set(p);
     s.add(encoding);
 
     int percent = 0;
+    vector<bool> forcedFalse;
 
-    while (!vars.empty()) {
-        auto outerVar = vars.back();
-        vars.pop_back();
-
-        int current = vars.size();
+    for (int current = vars.size() - 1; current >= 0 && !cancellation.IsCancelled(); --current) {
+        expr_vector assumptions{ ctx };
+        assumptions.push_back(vars[current]);
+        expr_vector earlier{ ctx };
+        for (int i = 0; i < current; ++i)
+            earlier.push_back(vars[i]);
+        expr_vector consequences{ ctx };
 
-        s.push();
-        s.add(outerVar);
-        for (int i = 0; i < vars.size(); ++i) {
-            expr_vector assumptions{ ctx };
-            assumptions.push_back(vars[i]);
-            if (s.check(assumptions) == sat)
-                GRAPH_ADD_EDGE(graph, current, i);
+        check_result result = unknown;
+        try {
+            result = s.consequences(assumptions, earlier, consequences);
+        } catch (z3::exception&) {
+            if (!cancellation.IsCancelled())
+                throw;
+        }
+        if (result == unknown && cancellation.IsCancelled())
+            break;
+        if (result == unknown)
+            throw SeddEcException(Reason::LOGIC_ERROR, FORMAT("Z3 could not decide " << vars[current]));
+        // An event that occurs in no configuration has no edges.
+        if (result == sat) {
+            forcedFalse.assign(current, false);
+            for (unsigned i = 0; i < consequences.size(); ++i) {
+                // Each consequence has the form assumptions => literal.
+                expr literal = consequences[i].arg(1);
+                if (literal.decl().decl_kind() == Z3_OP_NOT)
+                    forcedFalse[varIndex.at(Z3_get_ast_id(ctx, literal.arg(0)))] = true;
+            }
+            for (int i = 0; i < current; ++i)
+                if (!forcedFalse[i])
+                    GRAPH_ADD_EDGE(graph, current, i);
         }
-        s.pop();
 
-        int newPercent = (eventVars.size() - current) * 100.0 / eventVars.size();
-        if (newPercent != percent)
+        int newPercent = (vars.size() - current) * 100.0 / vars.size();
+        if (newPercent != percent && showProgress)
             cout << newPercent << "%\n";
         percent = newPercent;
     }
 
-    graph_test(graph, stdout);
+    graph_test(graph, showProgress ? stdout : nullptr);
     return graph;
 }
 
+// Parsed batches that may wait for the event structure builder when streaming.
+static const size_t StreamQueueCapacity = 8;
+
+std::unique_ptr<EventStructure> ReadEventStructure(string path, unsigned threads, bool stream) {
+    if (!stream)
+        return std::unique_ptr<EventStructure>(new EventStructure(ParseEventStructure(path, threads)));
+
+    EventStructure::Builder builder;
+    ParseEventStructure(path, StreamQueueCapacity, [&](EventList&& batch) {
+        builder.Append(std::move(batch));
+    });
+    return std::unique_ptr<EventStructure>(new EventStructure(std::move(builder)));
+}
+
+enum InputKind {
+    SMT2_INPUT,
+    ES_INPUT,
+    BINARY_ES_INPUT
+};
+
+// How the compatibility graph is built. SMT2 inputs can only use the Z3
+// based engines and fall back to Z3_ENGINE for the native ones.
+enum CographEngine {
+    Z3_ENGINE,
+    CONSEQUENCES_ENGINE,
+    TWO_SAT_ENGINE,
+    BITSET_ENGINE
+};
+
+struct RunOptions {
+    bool useCliquer;
+    unsigned threads;
+    unsigned testsPerRound;
+    unsigned cubeDepth;
+    bool stream;
+    CographEngine engine;
+    // No checkpoints are written when empty.
+    string checkpointPath;
+    double checkpointInterval;
+    // Continue from checkpointPath if it exists.
+    bool resume;
+    // No tests are written when empty.
+    string testsPath;
+};
+
+// Computes a cover for one input using ctx and returns the number of tests.
+size_t CoverInput(context& ctx, InputKind kind, string path, const RunOptions& options) {
+    CancellationScope scope(cancellation, ctx);
+    expr encoding{ ctx };
+    vector<expr> eventVars;
+    std::unique_ptr<EventStructure> events;
+    if (showProgress)
+        cout << "INPUT: " << path << std::endl;
+    if (kind == SMT2_INPUT) {
+        expr_vector assertions(ctx, Z3_parse_smtlib2_file(ctx, path.c_str(), 0, nullptr, nullptr, 0, nullptr, nullptr));
+        encoding = mk_and(assertions);
+        eventVars = GetEventVars(encoding);
+    }
+    else {
+        if (kind == ES_INPUT)
+            events = ReadEventStructure(path, options.threads, options.stream);
+        else
+            events.reset(new EventStructure(std::make_shared<MappedEventStructure>(path)));
+        encoding = EncodeEvents(ctx, *events);
+        eventVars = GetEventVars(ctx, *events);
+    }
+
+    vector<string> names;
+    for (auto& var : eventVars)
+        names.push_back(var.decl().name().str());
+
+    TestStream testStream;
+    if (!options.testsPath.empty())
+        testStream = TestStream(options.testsPath, names);
+
+    Checkpoint resumed;
+    Checkpointer checkpointer;
+    if (!options.checkpointPath.empty()) {
+        if (options.resume && std::ifstream(options.checkpointPath)) {
+            resumed = ReadCheckpoint(options.checkpointPath, names);
+            if (showProgress)
+                cout << "RESUMED: " << resumed.tests.size() << " tests" << (resumed.graph ? " and the cograph" : "") << std::endl;
+        }
+        checkpointer = Checkpointer(options.checkpointPath, names, options.checkpointInterval);
+    }
+
+    // Z3 may also be interrupted outside of checks, with nothing to show
+    // for the phase; then every event not covered by a test written so far
+    // gets a test of its own.
+    try {
+        if (options.useCliquer) {
+            graph_t* cograph;
+            if (resumed.graph) {
+                if (showProgress)
+                    cout << "METHOD: Cograph from checkpoint + Cliquer\n";
+                cograph = resumed.graph;
+            } else if (events && options.engine == TWO_SAT_ENGINE) {
+                if (showProgress)
+                    cout << "METHOD: Cograph from 2-SAT + Cliquer\n";
+                cograph = TwoSatCograph(*events);
+                graph_test(cograph, showProgress ? stdout : nullptr);
+            } else if (events && options.engine == BITSET_ENGINE) {
+                if (showProgress)
+                    cout << "METHOD: Cograph from causal index + Cliquer\n";
+                CausalIndex index(*events, options.threads);
+                cograph = BitsetCograph(*events, index, options.threads);
+                graph_test(cograph, showProgress ? stdout : nullptr);
+            } else if (options.engine == CONSEQUENCES_ENGINE) {
+                if (showProgress)
+                    cout << "METHOD: Cograph from Z3 consequences + Cliquer\n";
+                cograph = ConsequencesCograph(ctx, encoding, eventVars);
+            } else {
+                if (showProgress)
+                    cout << "METHOD: Cograph from Z3 + Cliquer\n";
+                cograph = SolveCograph(encoding, eventVars, options.threads);
+            }
+            // A graph cut short by cancellation must not be saved as finished.
+            if (cancellation.IsCancelled())
+                checkpointer = Checkpointer();
+            checkpointer.Save(cograph, resumed.tests, true);
+            auto numTests = CoverCograph(cograph, options.threads, resumed.tests, checkpointer, testStream);
+            graph_free(cograph);
+            return numTests;
+        } else {
+            if (resumed.graph)
+                graph_free(resumed.graph);
+            if (showProgress)
+                cout << "METHOD: Z3\n";
+            return Optimize(encoding, eventVars, options.testsPerRound, options.threads, options.cubeDepth, resumed.tests, checkpointer, testStream).size();
+        }
+    } catch (z3::exception&) {
+        if (!cancellation.IsCancelled())
+            throw;
+        return testStream.CoverRest(eventVars.size());
+    }
+}
+
+InputKind DetectInputKind(string path) {
+    string extension = ".smt2";
+    if (path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0)
+        return SMT2_INPUT;
+    return IsBinaryEventStructure(path) ? BINARY_ES_INPUT : ES_INPUT;
+}
+
+// Covers every input listed in listPath, one path per line, on a pool of
+// workers that each own a Z3 context. Writes one tab separated record per
+// input to out as soon as it is done: the path followed by either the method
+// name, test count and seconds taken, or "error" and a message. The method
+// name gets a "-stopped" suffix when the run was cancelled during the input.
+void RunBatch(string listPath, std::ostream& out, const RunOptions& options) {
+    vector<string> paths;
+    std::ifstream list(listPath);
+    if (!list)
+        throw SeddEcException(Reason::IO_ERROR, FORMAT("Cannot open " << listPath));
+    string line;
+    while (std::getline(list, line))
+        if (!line.empty())
+            paths.push_back(line);
+
+    unsigned workers = std::min<size_t>(ThreadCount(options.threads), std::max<size_t>(paths.size(), 1));
+    vector<std::unique_ptr<context>> contexts;
+    for (unsigned i = 0; i < workers; ++i)
+        contexts.emplace_back(new context);
+
+    RunOptions inputOptions = options;
+    inputOptions.threads = 1;
+    // One file cannot hold the checkpoints or tests of many inputs.
+    inputOptions.checkpointPath = "";
+    inputOptions.testsPath = "";
+    string method = options.useCliquer ? "cliquer" : "z3";
+    std::mutex outMutex;
+
+    ParallelFor(paths.size(), workers, [&](unsigned worker, size_t i) {
+        Timer timer;
+        string record;
+        if (cancellation.IsCancelled())
+            record = FORMAT(paths[i] << "\terror\tnot started, " << cancellation.Cause());
+        else try {
+            auto tests = CoverInput(*contexts[worker], DetectInputKind(paths[i]), paths[i], inputOptions);
+            string status = cancellation.IsCancelled() ? method + "-stopped" : method;
+            record = FORMAT(paths[i] << '\t' << status << '\t' << tests << '\t' << timer.elapsed());
+        } catch (SeddEcException& e) {
+            record = FORMAT(paths[i] << "\terror\t" << e.what());
+        } catch (z3::exception& e) {
+            record = FORMAT(paths[i] << "\terror\t" << e.msg());
+        }
+        std::lock_guard<std::mutex> lock(outMutex);
+        out << record << std::endl;
+    });
+}
+
 int main(int argc, char** argv) {
     totalTimer.reset();
 
@@ -374,43 +1100,101 @@ int main(int argc, char** argv) {
         cmd.add(cographPath);
         TCLAP::ValueArg<string> esPath("e", "event-structure", "Event structure input file", false, "", "path");
         cmd.add(esPath);
+        TCLAP::ValueArg<string> binaryEsPath("b", "binary-event-structure", "Binary event structure input file", false, "", "path");
+        cmd.add(binaryEsPath);
+        TCLAP::ValueArg<string> convertPath("", "convert", "Write the event structure input in binary format to path and exit", false, "", "path");
+        cmd.add(convertPath);
 
         TCLAP::SwitchArg useCliquer("c", "cliquer", "Solve a cograph and find tests with Cliquer");
         cmd.add(useCliquer);
+        TCLAP::ValueArg<unsigned> threads("j", "threads", "Number of worker threads (0 uses all cores)", false, 1, "count");
+        cmd.add(threads);
+        TCLAP::ValueArg<unsigned> testsPerRound("", "tests-per-round", "Number of tests Z3 looks for in each check when not using Cliquer", false, 1, "count");
+        cmd.add(testsPerRound);
+        TCLAP::ValueArg<unsigned> cubeDepth("", "cube-depth", "Split each Z3 search for tests on this many event variables (at most 16) and share the parts out between the threads", false, 0, "count");
+        cmd.add(cubeDepth);
+        TCLAP::SwitchArg stream("", "stream", "Build the event structure while the input is still being parsed");
+        cmd.add(stream);
+        vector<string> engineNames{ "z3", "consequences", "2sat", "bitset" };
+        TCLAP::ValuesConstraint<string> engineConstraint(engineNames);
+        TCLAP::ValueArg<string> engine("", "cograph-engine", "How to build the compatibility graph for Cliquer; SMT2 inputs use z3 unless consequences is given", false, "2sat", &engineConstraint);
+        cmd.add(engine);
+        TCLAP::ValueArg<string> batchPath("", "batch", "File listing one input path per line, covered in parallel", false, "", "path");
+        cmd.add(batchPath);
+        TCLAP::ValueArg<string> batchOutputPath("", "batch-output", "Where to write the batch results (default: standard output)", false, "", "path");
+        cmd.add(batchOutputPath);
+        TCLAP::ValueArg<double> deadline("", "deadline", "Stop after this many seconds (0 means never) and report the best cover found so far, with a test for each event left uncovered; SIGINT does the same", false, 0, "seconds");
+        cmd.add(deadline);
+        TCLAP::ValueArg<string> checkpointPath("", "checkpoint", "Save the cograph and the tests found so far to path periodically and when stopped (not in batch mode)", false, "", "path");
+        cmd.add(checkpointPath);
+        TCLAP::ValueArg<double> checkpointInterval("", "checkpoint-interval", "Seconds between checkpoints", false, 60, "seconds");
+        cmd.add(checkpointInterval);
+        TCLAP::SwitchArg resume("", "resume", "Continue from the --checkpoint file if it exists, skipping the phases it has finished");
+        cmd.add(resume);
+        TCLAP::ValueArg<string> testsPath("", "tests-output", "Write each test of the cover to path (a file or pipe) as soon as it is found, one line of event names per test (not in batch mode)", false, "", "path");
+        cmd.add(testsPath);
 		
         cmd.parse(argc, argv);
 
-        if (smt2Path.getValue() != "" || esPath.getValue() != "") {
-            context ctx;
-            expr encoding{ ctx };
-            if (smt2Path.getValue() != "") {
-                cout << "INPUT: " << smt2Path.getValue() << std::endl;
-                encoding = to_expr(ctx, Z3_parse_smtlib2_file(ctx, smt2Path.getValue().c_str(), 0, nullptr, nullptr, 0, nullptr, nullptr));
-            }
-            else {
-                cout << "INPUT: " << esPath.getValue() << std::endl;
-                auto events = ParseEventStructure(esPath.getValue());
-                encoding = EncodeEvents(ctx, events);
-            }
-            auto eventVars = GetEventVars(encoding);
-            if (useCliquer.getValue()) {
-                cout << "METHOD: Cograph from Z3 + Cliquer\n";
-                auto cograph = SolveCograph(ctx, encoding, eventVars);
-                auto numTests = CoverCograph(cograph);
-                graph_free(cograph);
-                cout << "Tests in cover (Cliquer): " << numTests << std::endl;
-            } else {
-                cout << "METHOD: Z3\n";
-                auto tests = Optimize(ctx, encoding, eventVars);
-                cout << "Tests in cover (Z3): " << tests.size() << std::endl;
+        unordered_map<string, CographEngine> engines{ { "z3", Z3_ENGINE }, { "consequences", CONSEQUENCES_ENGINE }, { "2sat", TWO_SAT_ENGINE }, { "bitset", BITSET_ENGINE } };
+        RunOptions options{ useCliquer.getValue(), threads.getValue(), std::max(testsPerRound.getValue(), 1u), cubeDepth.getValue(), stream.getValue(), engines.at(engine.getValue()),
+                            checkpointPath.getValue(), checkpointInterval.getValue(), resume.getValue(), testsPath.getValue() };
+        if (options.resume && options.checkpointPath == "") {
+            cerr << "Resuming needs a --checkpoint path\n";
+            return 1;
+        }
+        if (options.cubeDepth > MaxCubeDepth) {
+            cerr << "--cube-depth can be at most " << MaxCubeDepth << "\n";
+            return 1;
+        }
+
+        Watchdog watchdog(cancellation, deadline.getValue());
+
+        if (convertPath.getValue() != "") {
+            if (esPath.getValue() == "") {
+                cerr << "Conversion needs an event structure input\n";
+                return 1;
             }
+            auto events = ReadEventStructure(esPath.getValue(), threads.getValue(), stream.getValue());
+            WriteEventStructureBinary(*events, convertPath.getValue());
+            cout << "Converted " << events->size() << " events to " << convertPath.getValue() << std::endl;
+        }
+        else if (batchPath.getValue() != "") {
+            showProgress = false;
+            if (batchOutputPath.getValue() != "") {
+                std::ofstream out(batchOutputPath.getValue());
+                if (!out)
+                    throw SeddEcException(Reason::IO_ERROR, FORMAT("Cannot write " << batchOutputPath.getValue()));
+                RunBatch(batchPath.getValue(), out, options);
+            } else
+                RunBatch(batchPath.getValue(), cout, options);
+        }
+        else if (smt2Path.getValue() != "" || esPath.getValue() != "" || binaryEsPath.getValue() != "") {
+            context ctx;
+            size_t numTests;
+            if (smt2Path.getValue() != "")
+                numTests = CoverInput(ctx, SMT2_INPUT, smt2Path.getValue(), options);
+            else if (esPath.getValue() != "")
+                numTests = CoverInput(ctx, ES_INPUT, esPath.getValue(), options);
+            else
+                numTests = CoverInput(ctx, BINARY_ES_INPUT, binaryEsPath.getValue(), options);
+            if (cancellation.IsCancelled())
+                cout << "Stopped early (" << cancellation.Cause() << "), events left uncovered have a test each\n";
+            cout << "Tests in cover (" << (useCliquer.getValue() ? "Cliquer" : "Z3") << "): " << numTests << std::endl;
         }
         else if (cographPath.getValue() != "") {
             cout << "INPUT: " << cographPath.getValue() << std::endl;
             cout << "METHOD: Cliquer\n";
-            auto cograph = ParseCograph(cographPath.getValue());
-            auto numTests = CoverCograph(cograph);
+            vector<string> names;
+            auto cograph = ParseCograph(cographPath.getValue(), names);
+            Checkpointer noCheckpoints;
+            TestStream testStream;
+            if (testsPath.getValue() != "")
+                testStream = TestStream(testsPath.getValue(), names);
+            auto numTests = CoverCograph(cograph, threads.getValue(), {}, noCheckpoints, testStream);
             graph_free(cograph);
+            if (cancellation.IsCancelled())
+                cout << "Stopped early (" << cancellation.Cause() << "), events left uncovered have a test each\n";
             cout << "Tests in cover (Cliquer): " << numTests << std::endl;
         }
         else {
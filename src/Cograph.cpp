@@ -0,0 +1,83 @@
+#include "Pch.hpp"
+#include "Cograph.hpp"
+#include "TwoSat.hpp"
+#include "Parallel.hpp"
+
+graph_t* TwoSatCograph(const EventStructure& events) {
+    // The clauses EncodeEvents produces: each event implies its predecessors
+    // and excludes the events it is in immediate conflict with.
+    vector<pair<TwoSat::Literal, TwoSat::Literal>> clauses;
+    for (unsigned i = 0; i < events.size(); ++i) {
+        for (auto pred : events.predecessors(i))
+            clauses.emplace_back(TwoSat::Negative(i), TwoSat::Positive(pred));
+        for (auto conflict : events.conflicts(i))
+            if (conflict >= i)
+                clauses.emplace_back(TwoSat::Negative(i), TwoSat::Negative(conflict));
+    }
+    TwoSat formula(events.size(), clauses);
+
+    auto& leaves = events.leaves();
+    auto graph = graph_new(leaves.size());
+
+    for (unsigned k = 0; k < leaves.size(); ++k) {
+        if (!formula.Assume(TwoSat::Positive(leaves[k]))) {
+            formula.Backtrack(0);
+            continue;
+        }
+        size_t outer = formula.TrailSize();
+        for (unsigned j = 0; j < k; ++j) {
+            if (formula.Assume(TwoSat::Positive(leaves[j])))
+                GRAPH_ADD_EDGE(graph, k, j);
+            formula.Backtrack(outer);
+        }
+        formula.Backtrack(0);
+    }
+
+    return graph;
+}
+
+// Leaves compared against one row block before moving on, so that their
+// index rows stay in cache across the block.
+static const unsigned CographTileSize = 256;
+
+graph_t* BitsetCograph(const EventStructure& events, const CausalIndex& index, unsigned threads) {
+    auto& leaves = events.leaves();
+    unsigned count = leaves.size();
+    auto graph = graph_new(count);
+    // Tasks own the rows of one word column of the adjacency matrix and only
+    // ever write those rows, so no locking is needed.
+    unsigned blocks = (count + ELEMENTSIZE - 1) / ELEMENTSIZE;
+
+    // Lower triangle: row k gets the compatible leaves j < k.
+    ParallelFor(blocks, threads, [&](size_t block) {
+        unsigned first = block * ELEMENTSIZE;
+        unsigned last = std::min(first + ELEMENTSIZE, count);
+        for (unsigned tile = 0; tile < last; tile += CographTileSize) {
+            for (unsigned k = std::max(first, tile + 1); k < last; ++k) {
+                unsigned tileEnd = std::min(tile + CographTileSize, k);
+                for (unsigned j = tile; j < tileEnd; ++j)
+                    if (index.AreCompatible(leaves[k], leaves[j]))
+                        SET_ADD_ELEMENT(graph->edges[k], j);
+            }
+        }
+    });
+
+    // Upper triangle: mirror word column `block` of rows below into the rows
+    // of the block. Those words only hold lower triangle bits, which the
+    // first pass finished.
+    ParallelFor(blocks, threads, [&](size_t block) {
+        unsigned first = block * ELEMENTSIZE;
+        for (unsigned k = first + 1; k < count; ++k) {
+            setelement word = graph->edges[k][block];
+            if (k < first + ELEMENTSIZE)
+                word &= SET_BIT_MASK(k - first) - 1;
+            while (word) {
+                unsigned bit = __builtin_ctzl(word);
+                word &= word - 1;
+                SET_ADD_ELEMENT(graph->edges[first + bit], k);
+            }
+        }
+    });
+
+    return graph;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "EventStructure.hpp"
+#include "CausalIndex.hpp"
+#include "cliquer.h"
+
+// Native builders for the compatibility graph of an event structure, the
+// same graph SolveCograph computes with Z3 for its encoding. Vertex k stands
+// for the leaf events.leaves()[k], and two vertices are adjacent iff both
+// leaves can occur in one configuration.
+
+graph_t* TwoSatCograph(const EventStructure& events);
+
+// Tests each pair of leaves with one intersection of their index rows, on up
+// to `threads` threads.
+graph_t* BitsetCograph(const EventStructure& events, const CausalIndex& index, unsigned threads = 1);
@@ -0,0 +1,84 @@
+#include "Pch.hpp"
+#include "ESBinary.hpp"
+#include "SeddEcException.hpp"
+
+#include <cstring>
+
+static const char Magic[8] = { 'S', 'E', 'D', 'D', 'E', 'C', 'E', 'S' };
+static const uint32_t Version = 1;
+
+template<class T>
+static void WriteArray(std::ofstream& out, const vector<T>& array) {
+    out.write(reinterpret_cast<const char*>(array.data()), array.size() * sizeof(T));
+}
+
+void WriteEventStructureBinary(const EventStructure& events, string path) {
+    vector<uint32_t> ids, predecessorOffsets{ 0 }, predecessors, conflictOffsets{ 0 }, conflicts;
+    for (unsigned i = 0; i < events.size(); ++i) {
+        ids.push_back(events.id(i));
+        predecessors.insert(end(predecessors), begin(events.predecessors(i)), end(events.predecessors(i)));
+        predecessorOffsets.push_back(predecessors.size());
+        conflicts.insert(end(conflicts), begin(events.conflicts(i)), end(events.conflicts(i)));
+        conflictOffsets.push_back(conflicts.size());
+    }
+
+    ESBinaryHeader header;
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.eventCount = ids.size();
+    header.predecessorCount = predecessors.size();
+    header.conflictCount = conflicts.size();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    WriteArray(out, ids);
+    WriteArray(out, predecessorOffsets);
+    WriteArray(out, predecessors);
+    WriteArray(out, conflictOffsets);
+    WriteArray(out, conflicts);
+    out.close();
+    if (!out)
+        throw SeddEcException(Reason::IO_ERROR, FORMAT("Cannot write " << path));
+}
+
+bool IsBinaryEventStructure(string path) {
+    char magic[sizeof(Magic)];
+    std::ifstream in(path, std::ios::binary);
+    return in.read(magic, sizeof(magic)) && memcmp(magic, Magic, sizeof(Magic)) == 0;
+}
+
+static void CheckCsr(const unsigned* offsets, const unsigned* indices, uint32_t rows, uint32_t count) {
+    if (offsets[0] != 0 || offsets[rows] != count)
+        throw SeddEcException(Reason::INVALID_INPUT_FORMAT, "Corrupt binary event structure offsets");
+    for (uint32_t i = 0; i < rows; ++i)
+        if (offsets[i] > offsets[i + 1])
+            throw SeddEcException(Reason::INVALID_INPUT_FORMAT, "Corrupt binary event structure offsets");
+    for (uint32_t i = 0; i < count; ++i)
+        if (indices[i] >= rows)
+            throw SeddEcException(Reason::INVALID_INPUT_FORMAT, "Corrupt binary event structure index");
+}
+
+MappedEventStructure::MappedEventStructure(string path) : file_(path) {
+    ESBinaryHeader header;
+    if (file_.size() < sizeof(header))
+        throw SeddEcException(Reason::INVALID_INPUT_FORMAT, FORMAT(path << " is not a binary event structure"));
+    memcpy(&header, file_.begin(), sizeof(header));
+    if (memcmp(header.magic, Magic, sizeof(Magic)) != 0)
+        throw SeddEcException(Reason::INVALID_INPUT_FORMAT, FORMAT(path << " is not a binary event structure"));
+    if (header.version != Version)
+        throw SeddEcException(Reason::INVALID_INPUT_FORMAT, FORMAT("Unsupported binary event structure version " << header.version));
+
+    uint64_t words = 3 * uint64_t(header.eventCount) + 2 + header.predecessorCount + header.conflictCount;
+    if (file_.size() != sizeof(header) + words * sizeof(uint32_t))
+        throw SeddEcException(Reason::INVALID_INPUT_FORMAT, FORMAT(path << " has the wrong size for its header"));
+
+    count_ = header.eventCount;
+    ids_ = reinterpret_cast<const unsigned*>(file_.begin() + sizeof(header));
+    predecessorOffsets_ = ids_ + count_;
+    predecessors_ = predecessorOffsets_ + count_ + 1;
+    conflictOffsets_ = predecessors_ + header.predecessorCount;
+    conflicts_ = conflictOffsets_ + count_ + 1;
+
+    CheckCsr(predecessorOffsets_, predecessors_, count_, header.predecessorCount);
+    CheckCsr(conflictOffsets_, conflicts_, count_, header.conflictCount);
+}
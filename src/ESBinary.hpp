@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+#include "EventStructure.hpp"
+#include "MappedFile.hpp"
+
+// Binary event structure layout, all integers in native byte order:
+//
+//   ESBinaryHeader
+//   uint32_t ids[eventCount]                    original id of each event
+//   uint32_t predecessorOffsets[eventCount + 1]
+//   uint32_t predecessors[predecessorCount]     dense event indices
+//   uint32_t conflictOffsets[eventCount + 1]
+//   uint32_t conflicts[conflictCount]           dense event indices
+//
+// The predecessors of event i are predecessors[predecessorOffsets[i]] up to
+// predecessors[predecessorOffsets[i + 1]], and likewise for conflicts.
+struct ESBinaryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t eventCount;
+    uint32_t predecessorCount;
+    uint32_t conflictCount;
+};
+
+static_assert(sizeof(unsigned) == sizeof(uint32_t), "the binary format is read as unsigned arrays");
+
+void WriteEventStructureBinary(const EventStructure& events, string path);
+
+// Checks whether path starts like a binary event structure.
+bool IsBinaryEventStructure(string path);
+
+// A binary event structure mapped read-only into memory. All arrays point
+// into the mapping, so loading costs one validation pass over the file.
+// EventStructure borrows them from here.
+class MappedEventStructure {
+public:
+    explicit MappedEventStructure(string path);
+
+    unsigned size() const { return count_; }
+    const unsigned* ids() const { return ids_; }
+    const unsigned* predecessorOffsets() const { return predecessorOffsets_; }
+    const unsigned* predecessors() const { return predecessors_; }
+    const unsigned* conflictOffsets() const { return conflictOffsets_; }
+    const unsigned* conflicts() const { return conflicts_; }
+private:
+    MappedFile file_;
+    unsigned count_;
+    const unsigned* ids_;
+    const unsigned* predecessorOffsets_;
+    const unsigned* predecessors_;
+    const unsigned* conflictOffsets_;
+    const unsigned* conflicts_;
+};
@@ -1,7 +1,12 @@
 #include "Pch.hpp"
 #include "ESParser.hpp"
+#include "MappedFile.hpp"
+#include "Parallel.hpp"
+#include "BoundedQueue.hpp"
 #include "SeddEcException.hpp"
 
+#include <cstring>
+
 #define TOKEN_TYPE_TABLE \
 X(LPAREN) \
 X(RPAREN) \
@@ -22,43 +27,88 @@ string tokenName[] = {
 };
 #undef X
 
+// Token text points straight into the mapped file and is never copied.
+struct StringView {
+    const char* begin;
+    const char* end;
+
+    bool operator==(const char* other) const {
+        size_t length = end - begin;
+        return strlen(other) == length && std::equal(begin, end, other);
+    }
+    bool operator!=(const char* other) const { return !(*this == other); }
+};
+
+std::ostream& operator<<(std::ostream& out, StringView view) {
+    return out.write(view.begin, view.end - view.begin);
+}
+
 struct Token {
     Type type;
-    string value;
+    StringView value;
+    unsigned number;
 };
 
-static unsigned lineNum = 0;
-static unsigned colNum;
+// Parses the lines of one chunk of the input. All state lives in the parser,
+// so chunks of the same file can be parsed concurrently. Positions are only
+// computed when an error is reported, counting lines from the file start.
+class EventParser {
+public:
+    EventParser(const char* fileStart) : fileStart_(fileStart) {}
+
+    // Parses up to maxEvents lines and returns where parsing stopped.
+    const char* ParseLines(const char* begin, const char* end, EventList& events,
+                           size_t maxEvents = std::numeric_limits<size_t>::max());
+private:
+    Token NextToken();
+    void Expect(const Token& token, Type type);
+    void Expect(const Token& token, Type type, const char* value);
+    void IgnoreLevel();
+    void IgnoreExpression();
+    void ParseIdList(vector<unsigned>& idList, size_t start);
+    void ParseEvent(EventList& events);
+
+    unsigned LineNumber() const { return 1 + std::count(fileStart_, lineStart_, '\n'); }
+    unsigned ColumnNumber() const { return pos_ - lineStart_; }
+
+    const char* fileStart_;
+    const char* lineStart_;
+    // The unparsed remainder of the current line.
+    const char* pos_;
+    const char* end_;
+};
 
-#define AT_FORMAT " at line " << lineNum << " column " << colNum
+#define AT_FORMAT " at line " << LineNumber() << " column " << ColumnNumber()
 
-Token NextToken(std::stringstream& input) {
-    std::stringstream value;
+Token EventParser::NextToken() {
+    Token token;
     int c;
 
 GET_FIRST:
     {
-        ++colNum; c = input.get();
-        switch(c) {
-        case EOF:
+        if (pos_ == end_)
             throw SeddEcException(Reason::INVALID_INPUT_FORMAT, FORMAT("Unexpected end-of-line" << AT_FORMAT));
+        c = *pos_++;
+        token.value.begin = pos_ - 1;
+        switch(c) {
         case ' ':
             goto GET_FIRST;
         case '(':
         case '{':
         case '[':
-            value << (char)c;
-            return Token{ LPAREN, value.str() };
+            token.type = LPAREN;
+            goto SINGLE;
         case ')':
         case '}':
         case ']':
-            value << (char)c;
-            return Token{ RPAREN, value.str() };
+            token.type = RPAREN;
+            goto SINGLE;
         case '=':
         case ',':
-            value << (char)c;
-            return Token{ OPERATOR, value.str() };
+            token.type = OPERATOR;
+            goto SINGLE;
         case '\"':
+            ++token.value.begin;
             goto SCAN_STRING;
         case '0':
         case '1':
@@ -70,174 +120,292 @@ GET_FIRST:
         case '7':
         case '8':
         case '9':
-            value << (char)c;
+            token.number = c - '0';
             goto SCAN_INTEGER;
         default:
-            value << (char)c;
             goto SCAN_ID;
         }
     }
 
+SINGLE:
+    token.value.end = pos_;
+    return token;
+
 SCAN_ID:
     {
-        c = input.peek();
-        switch(c) {
-        case EOF:
-        case ' ':
-        case '(':
-        case '{':
-        case '[':
-        case ')':
-        case '}':
-        case ']':
-        case '=':
-        case ',':
-        case '\"':
-            return Token{ IDENTIFIER, value.str() };
-        default:
-            ++colNum; input.get();
-            value << (char)c;
-            goto SCAN_ID;
+        if (pos_ != end_) {
+            switch(*pos_) {
+            case ' ':
+            case '(':
+            case '{':
+            case '[':
+            case ')':
+            case '}':
+            case ']':
+            case '=':
+            case ',':
+            case '\"':
+                break;
+            default:
+                ++pos_;
+                goto SCAN_ID;
+            }
         }
+        token.type = IDENTIFIER;
+        token.value.end = pos_;
+        return token;
     }
 
 SCAN_STRING:
     {
-        c = input.peek();
-        switch(c) {
-        case EOF:
+        const char* quote = static_cast<const char*>(memchr(pos_, '\"', end_ - pos_));
+        if (!quote) {
+            pos_ = end_;
             throw SeddEcException(Reason::INVALID_INPUT_FORMAT, FORMAT("Unmatched \"" << AT_FORMAT));
-        case '\"':
-            ++colNum; input.get();
-            return Token{ STRING, value.str() };
-        default:
-            ++colNum; input.get();
-            value << (char)c;
-            goto SCAN_STRING;
         }
+        pos_ = quote + 1;
+        token.type = STRING;
+        token.value.end = quote;
+        return token;
     }
 
 SCAN_INTEGER:
     {
-        c = input.peek();
-        switch(c) {
-        case '0':
-        case '1':
-        case '2':
-        case '3':
-        case '4':
-        case '5':
-        case '6':
-        case '7':
-        case '8':
-        case '9':
-            ++colNum; input.get();
-            value << (char)c;
-            goto SCAN_INTEGER;
-        default:
-            return Token{ INTEGER, value.str() };
+        for (; pos_ != end_ && *pos_ >= '0' && *pos_ <= '9'; ++pos_) {
+            unsigned digit = *pos_ - '0';
+            if (token.number > (std::numeric_limits<unsigned>::max() - digit) / 10)
+                throw SeddEcException(Reason::INVALID_INPUT_FORMAT, FORMAT("Integer out of range" << AT_FORMAT));
+            token.number = token.number * 10 + digit;
         }
+        token.type = INTEGER;
+        token.value.end = pos_;
+        return token;
     }
 }
 
-void Expect(Token token, Type type) {
+void EventParser::Expect(const Token& token, Type type) {
     if (token.type != type)
         throw SeddEcException(Reason::INVALID_INPUT_FORMAT, FORMAT("Unexpected token: " << token.value << " (" << tokenName[token.type] << ")" << AT_FORMAT
             << " Expected (" << tokenName[type] << ")"));
 }
 
-void Expect(Token token, Type type, string value) {
+void EventParser::Expect(const Token& token, Type type, const char* value) {
     if (token.type != type || token.value != value)
         throw SeddEcException(Reason::INVALID_INPUT_FORMAT, FORMAT("Unexpected token: " << token.value << AT_FORMAT
             << " Expected " << value << " (" << tokenName[type] << ")"));
 }
 
-void IgnoreLevel(std::stringstream& input) {
-    Token token;
-    do {
-        token = NextToken(input);
-        if (token.type == LPAREN)
-            IgnoreLevel(input);
-    } while(token.type != RPAREN);
+// Skips a bracketed expression whose opening bracket has been consumed. Only
+// bracket depth and string literals matter, so no tokens are produced.
+void EventParser::IgnoreLevel() {
+    unsigned depth = 1;
+    while (pos_ != end_) {
+        switch (*pos_++) {
+        case '(':
+        case '{':
+        case '[':
+            ++depth;
+            break;
+        case ')':
+        case '}':
+        case ']':
+            if (--depth == 0)
+                return;
+            break;
+        case '\"': {
+            const char* quote = static_cast<const char*>(memchr(pos_, '\"', end_ - pos_));
+            if (!quote) {
+                pos_ = end_;
+                throw SeddEcException(Reason::INVALID_INPUT_FORMAT, FORMAT("Unmatched \"" << AT_FORMAT));
+            }
+            pos_ = quote + 1;
+            break;
+        }
+        }
+    }
+    throw SeddEcException(Reason::INVALID_INPUT_FORMAT, FORMAT("Unexpected end-of-line" << AT_FORMAT));
 }
 
-void IgnoreExpression(std::stringstream& input) {
-    auto token = NextToken(input);
+void EventParser::IgnoreExpression() {
+    auto token = NextToken();
     if (token.type == LPAREN)
-        IgnoreLevel(input);
+        IgnoreLevel();
 }
 
-vector<unsigned> ParseIdList(std::stringstream& input) {
-    vector<unsigned> idList;
+// Replaces idList[start...] with the parsed list, so a repeated field
+// overrides the earlier one.
+void EventParser::ParseIdList(vector<unsigned>& idList, size_t start) {
+    idList.resize(start);
 
-    Expect(NextToken(input), LPAREN);
+    Expect(NextToken(), LPAREN);
     bool first = true;
     for (;;) {
-        auto token = NextToken(input);
+        auto token = NextToken();
         if (token.type == RPAREN)
-            return idList;
+            return;
         if (!first) {
             Expect(token, OPERATOR, ",");
-            token = NextToken(input);
+            token = NextToken();
         }
         Expect(token, INTEGER);
-        idList.emplace_back(std::stoi(token.value));
+        idList.emplace_back(token.number);
         first = false;
     }
 }
 
-Event ParseEvent(std::stringstream& input) {
-    Event event;
+void EventParser::ParseEvent(EventList& events) {
+    size_t predecessorStart = events.predecessors.size();
+    size_t conflictStart = events.conflicts.size();
 
-    Expect(NextToken(input), LPAREN);
-    auto idToken = NextToken(input);
+    Expect(NextToken(), LPAREN);
+    auto idToken = NextToken();
     Expect(idToken, INTEGER);
-    event.id = std::stoi(idToken.value);
 
-    Expect(NextToken(input), OPERATOR, ",");
-    Expect(NextToken(input), IDENTIFIER, "Event");
+    Expect(NextToken(), OPERATOR, ",");
+    Expect(NextToken(), IDENTIFIER, "Event");
     
-    Expect(NextToken(input), LPAREN);
+    Expect(NextToken(), LPAREN);
     bool first = true;
     for (;;) {
-        auto token = NextToken(input);
+        auto token = NextToken();
         if (token.type == RPAREN)
             break;
         if (!first) {
             Expect(token, OPERATOR, ",");
-            token = NextToken(input);
+            token = NextToken();
         }
         Expect(token, IDENTIFIER);
         if (token.value == "pred") {
-            Expect(NextToken(input), OPERATOR, "=");
-            event.predecessors = ParseIdList(input);
+            Expect(NextToken(), OPERATOR, "=");
+            ParseIdList(events.predecessors, predecessorStart);
         }
         else if (token.value == "icnf") {
-            Expect(NextToken(input), OPERATOR, "=");
-            event.conflicts = ParseIdList(input);
+            Expect(NextToken(), OPERATOR, "=");
+            ParseIdList(events.conflicts, conflictStart);
         } else {
-            Expect(NextToken(input), OPERATOR, "=");
-            IgnoreExpression(input);
+            Expect(NextToken(), OPERATOR, "=");
+            IgnoreExpression();
         }
         first = false;
     }
 
-    Expect(NextToken(input), RPAREN);
+    Expect(NextToken(), RPAREN);
+
+    events.ids.push_back(idToken.number);
+    events.predecessorOffsets.push_back(events.predecessors.size());
+    events.conflictOffsets.push_back(events.conflicts.size());
+}
+
+const char* EventParser::ParseLines(const char* begin, const char* end, EventList& events, size_t maxEvents) {
+    for (lineStart_ = begin; lineStart_ != end && maxEvents-- != 0;) {
+        auto lineEnd = static_cast<const char*>(memchr(lineStart_, '\n', end - lineStart_));
+        auto next = lineEnd ? lineEnd + 1 : end;
+
+        pos_ = lineStart_;
+        end_ = lineEnd ? lineEnd : end;
+        ParseEvent(events);
+
+        lineStart_ = next;
+    }
+    return lineStart_;
+}
+
+void EventList::Append(const EventList& other) {
+    auto appendRows = [](vector<unsigned>& offsets, vector<unsigned>& indices,
+                         const vector<unsigned>& otherOffsets, const vector<unsigned>& otherIndices) {
+        unsigned base = indices.size();
+        indices.insert(end(indices), begin(otherIndices), end(otherIndices));
+        for (auto it = begin(otherOffsets) + 1; it != end(otherOffsets); ++it)
+            offsets.push_back(base + *it);
+    };
+    ids.insert(end(ids), begin(other.ids), end(other.ids));
+    appendRows(predecessorOffsets, predecessors, other.predecessorOffsets, other.predecessors);
+    appendRows(conflictOffsets, conflicts, other.conflictOffsets, other.conflicts);
+}
+
+// Inputs smaller than this are not worth splitting.
+static const size_t MinChunkSize = 1 << 20;
+
+EventList ParseEventStructure(string path, unsigned threads) {
+    MappedFile file(path);
+
+    threads = ThreadCount(threads);
+    size_t chunkCount = threads == 1 ? 1 : std::max<size_t>(1, std::min<size_t>(threads * 4, file.size() / MinChunkSize));
+
+    // Chunk i covers [bounds[i], bounds[i + 1]), each boundary placed just after a newline.
+    vector<const char*> bounds{ file.begin() };
+    for (size_t i = 1; i < chunkCount; ++i) {
+        auto target = std::max(bounds.back(), file.begin() + file.size() / chunkCount * i);
+        auto newline = static_cast<const char*>(memchr(target, '\n', file.end() - target));
+        if (!newline || newline + 1 == file.end())
+            break;
+        bounds.push_back(newline + 1);
+    }
+    bounds.push_back(file.end());
+    chunkCount = bounds.size() - 1;
+
+    vector<EventList> chunks(chunkCount);
+    ParallelFor(chunkCount, threads, [&](size_t i) {
+        EventParser(file.begin()).ParseLines(bounds[i], bounds[i + 1], chunks[i]);
+    });
+
+    if (chunkCount == 1)
+        return std::move(chunks[0]);
 
-    return event;
+    size_t events = 0, predecessors = 0, conflicts = 0;
+    for (auto& chunk : chunks) {
+        events += chunk.size();
+        predecessors += chunk.predecessors.size();
+        conflicts += chunk.conflicts.size();
+    }
+    EventList merged;
+    merged.ids.reserve(events);
+    merged.predecessorOffsets.reserve(events + 1);
+    merged.predecessors.reserve(predecessors);
+    merged.conflictOffsets.reserve(events + 1);
+    merged.conflicts.reserve(conflicts);
+    for (auto& chunk : chunks) {
+        merged.Append(chunk);
+        chunk = EventList();
+    }
+
+    return merged;
 }
 
-vector<Event> ParseEventStructure(string path) {
-    std::ifstream file(path);
+// Events per batch handed to the consumer when streaming.
+static const size_t StreamBatchSize = 1 << 14;
 
-    vector<Event> events;
+void ParseEventStructure(string path, size_t queueCapacity, const std::function<void(EventList&&)>& consume) {
+    MappedFile file(path);
+    BoundedQueue<EventList> batches(queueCapacity);
+    std::exception_ptr error;
+
+    std::thread producer([&]() {
+        try {
+            EventParser parser(file.begin());
+            for (auto pos = file.begin(); pos != file.end();) {
+                EventList batch;
+                pos = parser.ParseLines(pos, file.end(), batch, StreamBatchSize);
+                if (!batches.Push(std::move(batch)))
+                    break;
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+        batches.Close();
+    });
 
-    string line;
-    for(;std::getline(file, line);) {
-        ++lineNum;
-        std::stringstream remainingLine{ line };
-        events.emplace_back(ParseEvent(remainingLine));
+    try {
+        EventList batch;
+        while (batches.Pop(batch))
+            consume(std::move(batch));
+    } catch (...) {
+        batches.Close();
+        producer.join();
+        throw;
     }
+    producer.join();
 
-    return events;
+    if (error)
+        std::rethrow_exception(error);
 }
@@ -1,9 +1,26 @@
 #pragma once
 
-struct Event {
-    unsigned id;
+#include <functional>
+
+// Events in input order, referring to each other by their original ids. The
+// predecessors of the i-th event are predecessors[predecessorOffsets[i]] up
+// to predecessors[predecessorOffsets[i + 1]], and likewise for conflicts.
+struct EventList {
+    vector<unsigned> ids;
+    vector<unsigned> predecessorOffsets{ 0 };
     vector<unsigned> predecessors;
+    vector<unsigned> conflictOffsets{ 0 };
     vector<unsigned> conflicts;
+
+    size_t size() const { return ids.size(); }
+    void Append(const EventList& other);
 };
 
-vector<Event> ParseEventStructure(string);
\ No newline at end of file
+// Parses a textual event structure, splitting it over `threads` threads
+// (0 uses all cores).
+EventList ParseEventStructure(string path, unsigned threads = 1);
+
+// Parses a textual event structure on a background thread, passing batches of
+// consecutive events to `consume` on the calling thread. At most
+// `queueCapacity` parsed batches wait for the consumer at any time.
+void ParseEventStructure(string path, size_t queueCapacity, const std::function<void(EventList&&)>& consume);
\ No newline at end of file
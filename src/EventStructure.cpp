@@ -0,0 +1,118 @@
+#include "Pch.hpp"
+#include "EventStructure.hpp"
+#include "ESBinary.hpp"
+#include "SeddEcException.hpp"
+
+void EventStructure::Builder::Append(EventList&& batch) {
+    size_t first = events_.size();
+    if (first + batch.size() >= std::numeric_limits<unsigned>::max())
+        throw SeddEcException(Reason::INVALID_INPUT_FORMAT, "Too many events");
+
+    for (size_t i = 0; i < batch.size(); ++i)
+        if (!index_.emplace(batch.ids[i], first + i).second)
+            throw SeddEcException(Reason::INVALID_INPUT_FORMAT, FORMAT("Duplicate event id " << batch.ids[i]));
+
+    size_t firstPredecessor = events_.predecessors.size();
+    size_t firstConflict = events_.conflicts.size();
+    if (first == 0)
+        events_ = std::move(batch);
+    else
+        events_.Append(batch);
+    Remap(events_.predecessors, firstPredecessor, unresolvedPredecessors_);
+    Remap(events_.conflicts, firstConflict, unresolvedConflicts_);
+}
+
+void EventStructure::Builder::Remap(vector<unsigned>& indices, size_t from, vector<size_t>& unresolved) {
+    for (size_t k = from; k < indices.size(); ++k) {
+        auto found = index_.find(indices[k]);
+        if (found == end(index_))
+            unresolved.push_back(k);
+        else
+            indices[k] = found->second;
+    }
+}
+
+void EventStructure::Builder::Resolve(const vector<unsigned>& offsets, vector<unsigned>& indices, const vector<size_t>& unresolved) {
+    for (auto k : unresolved) {
+        auto found = index_.find(indices[k]);
+        if (found == end(index_)) {
+            auto row = std::upper_bound(begin(offsets), end(offsets), k) - begin(offsets) - 1;
+            throw SeddEcException(Reason::INVALID_INPUT_FORMAT, FORMAT("Unknown event id " << indices[k] << " referenced by event " << events_.ids[row]));
+        }
+        indices[k] = found->second;
+    }
+}
+
+EventStructure::EventStructure(Builder&& builder) : size_(builder.events_.size()) {
+    auto& events = builder.events_;
+    builder.Resolve(events.predecessorOffsets, events.predecessors, builder.unresolvedPredecessors_);
+    builder.Resolve(events.conflictOffsets, events.conflicts, builder.unresolvedConflicts_);
+    unordered_map<unsigned, unsigned>().swap(builder.index_);
+
+    ownedIds_ = std::move(events.ids);
+    ownedPredecessorOffsets_ = std::move(events.predecessorOffsets);
+    ownedPredecessors_ = std::move(events.predecessors);
+    ids_ = ownedIds_.data();
+    predecessorOffsets_ = ownedPredecessorOffsets_.data();
+    predecessors_ = ownedPredecessors_.data();
+
+    Index(events.conflictOffsets.data(), events.conflicts.data());
+}
+
+EventStructure::EventStructure(std::shared_ptr<const MappedEventStructure> mapped) :
+        size_(mapped->size()), mapped_(mapped),
+        ids_(mapped->ids()), predecessorOffsets_(mapped->predecessorOffsets()), predecessors_(mapped->predecessors()) {
+    Index(mapped->conflictOffsets(), mapped->conflicts());
+}
+
+// Builds the CSR transpose of the relation given by offsets and indices.
+static void Transpose(unsigned size, const unsigned* offsets, const unsigned* indices,
+                      vector<unsigned>& transposedOffsets, vector<unsigned>& transposed) {
+    transposedOffsets.assign(size + 1, 0);
+    for (unsigned k = 0; k < offsets[size]; ++k)
+        ++transposedOffsets[indices[k] + 1];
+    for (unsigned i = 0; i < size; ++i)
+        transposedOffsets[i + 1] += transposedOffsets[i];
+
+    transposed.resize(offsets[size]);
+    vector<unsigned> fill(begin(transposedOffsets), end(transposedOffsets) - 1);
+    for (unsigned i = 0; i < size; ++i)
+        for (unsigned k = offsets[i]; k < offsets[i + 1]; ++k)
+            transposed[fill[indices[k]]++] = i;
+}
+
+void EventStructure::Index(const unsigned* conflictOffsets, const unsigned* conflicts) {
+    Transpose(size_, predecessorOffsets_, predecessors_, successorOffsets_, successors_);
+
+    vector<unsigned> reverseOffsets, reverse;
+    Transpose(size_, conflictOffsets, conflicts, reverseOffsets, reverse);
+    conflictOffsets_.reserve(size_ + 1);
+    conflictOffsets_.push_back(0);
+    conflicts_.reserve(2 * conflictOffsets[size_]);
+    for (unsigned i = 0; i < size_; ++i) {
+        auto rowStart = conflicts_.size();
+        conflicts_.insert(end(conflicts_), conflicts + conflictOffsets[i], conflicts + conflictOffsets[i + 1]);
+        conflicts_.insert(end(conflicts_), reverse.data() + reverseOffsets[i], reverse.data() + reverseOffsets[i + 1]);
+        std::sort(begin(conflicts_) + rowStart, end(conflicts_));
+        conflicts_.erase(std::unique(begin(conflicts_) + rowStart, end(conflicts_)), end(conflicts_));
+        conflictOffsets_.push_back(conflicts_.size());
+    }
+
+    for (unsigned i = 0; i < size_; ++i)
+        if (isLeaf(i))
+            leaves_.push_back(i);
+
+    vector<unsigned> waiting(size_);
+    topologicalOrder_.reserve(size_);
+    for (unsigned i = 0; i < size_; ++i) {
+        waiting[i] = predecessorOffsets_[i + 1] - predecessorOffsets_[i];
+        if (waiting[i] == 0)
+            topologicalOrder_.push_back(i);
+    }
+    for (size_t k = 0; k < topologicalOrder_.size(); ++k)
+        for (auto successor : successors(topologicalOrder_[k]))
+            if (--waiting[successor] == 0)
+                topologicalOrder_.push_back(successor);
+    if (topologicalOrder_.size() != size_)
+        throw SeddEcException(Reason::INVALID_INPUT_FORMAT, "Causality relation has a cycle");
+}
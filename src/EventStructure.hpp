@@ -0,0 +1,80 @@
+#pragma once
+
+#include "ESParser.hpp"
+
+class MappedEventStructure;
+
+// An event structure with events renumbered densely as 0, ..., size() - 1.
+// Predecessors, successors and conflicts are stored as CSR arrays of dense
+// indices. Conflicts are symmetric: each immediate conflict appears in the
+// rows of both events. Predecessors and ids are borrowed from a mapped
+// binary file when constructed from one.
+class EventStructure {
+public:
+    // Collects parsed batches and remaps their ids to dense indices as they
+    // arrive, so that streaming input overlaps this work with parsing.
+    // References to events not seen yet are resolved when building.
+    class Builder {
+    public:
+        Builder() {}
+        explicit Builder(EventList&& events) { Append(std::move(events)); }
+
+        void Append(EventList&& batch);
+    private:
+        friend class EventStructure;
+
+        void Remap(vector<unsigned>& indices, size_t from, vector<size_t>& unresolved);
+        void Resolve(const vector<unsigned>& offsets, vector<unsigned>& indices, const vector<size_t>& unresolved);
+
+        EventList events_;
+        unordered_map<unsigned, unsigned> index_;
+        vector<size_t> unresolvedPredecessors_;
+        vector<size_t> unresolvedConflicts_;
+    };
+
+    // Fails on duplicate or unknown ids and on causality cycles.
+    explicit EventStructure(Builder&& builder);
+    explicit EventStructure(EventList&& events) : EventStructure(Builder(std::move(events))) {}
+    explicit EventStructure(std::shared_ptr<const MappedEventStructure> mapped);
+
+    EventStructure(const EventStructure&) = delete;
+    EventStructure& operator=(const EventStructure&) = delete;
+
+    unsigned size() const { return size_; }
+    unsigned id(unsigned event) const { return ids_[event]; }
+
+    Span<unsigned> predecessors(unsigned event) const {
+        return Span<unsigned>(predecessors_ + predecessorOffsets_[event], predecessors_ + predecessorOffsets_[event + 1]);
+    }
+    Span<unsigned> successors(unsigned event) const {
+        return Span<unsigned>(successors_.data() + successorOffsets_[event], successors_.data() + successorOffsets_[event + 1]);
+    }
+    Span<unsigned> conflicts(unsigned event) const {
+        return Span<unsigned>(conflicts_.data() + conflictOffsets_[event], conflicts_.data() + conflictOffsets_[event + 1]);
+    }
+
+    bool isLeaf(unsigned event) const { return successorOffsets_[event] == successorOffsets_[event + 1]; }
+    // Events without successors, in increasing index order.
+    const vector<unsigned>& leaves() const { return leaves_; }
+    // Every event appears after all of its predecessors.
+    const vector<unsigned>& topologicalOrder() const { return topologicalOrder_; }
+private:
+    void Index(const unsigned* conflictOffsets, const unsigned* conflicts);
+
+    unsigned size_;
+
+    std::shared_ptr<const MappedEventStructure> mapped_;
+    vector<unsigned> ownedIds_;
+    vector<unsigned> ownedPredecessorOffsets_;
+    vector<unsigned> ownedPredecessors_;
+    const unsigned* ids_;
+    const unsigned* predecessorOffsets_;
+    const unsigned* predecessors_;
+
+    vector<unsigned> successorOffsets_;
+    vector<unsigned> successors_;
+    vector<unsigned> conflictOffsets_;
+    vector<unsigned> conflicts_;
+    vector<unsigned> leaves_;
+    vector<unsigned> topologicalOrder_;
+};
@@ -0,0 +1,54 @@
+#include "Pch.hpp"
+#include "MappedFile.hpp"
+#include "SeddEcException.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+MappedFile::MappedFile(string path) : data_(nullptr), size_(0), mapped_(false) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw SeddEcException(Reason::IO_ERROR, FORMAT("Cannot open " << path << ": " << strerror(errno)));
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        size_ = info.st_size;
+        if (size_ == 0) {
+            close(fd);
+            return;
+        }
+        void* address = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            madvise(address, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(address);
+            mapped_ = true;
+            close(fd);
+            return;
+        }
+    }
+
+    char chunk[1 << 16];
+    ssize_t count;
+    while ((count = read(fd, chunk, sizeof(chunk))) != 0) {
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+            int error = errno;
+            close(fd);
+            throw SeddEcException(Reason::IO_ERROR, FORMAT("Cannot read " << path << ": " << strerror(error)));
+        }
+        buffer_.append(chunk, count);
+    }
+    close(fd);
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+}
+
+MappedFile::~MappedFile() {
+    if (mapped_)
+        munmap(const_cast<char*>(data_), size_);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+// Read-only view of a whole input file. Regular files are memory-mapped;
+// inputs that cannot be mapped (pipes, terminals) are read into a buffer.
+class MappedFile {
+public:
+    explicit MappedFile(string path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* begin() const { return data_; }
+    const char* end() const { return data_ + size_; }
+    size_t size() const { return size_; }
+private:
+    const char* data_;
+    size_t size_;
+    bool mapped_;
+    string buffer_;
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Resolves a user supplied thread count, where 0 means all hardware threads.
+inline unsigned ThreadCount(unsigned requested) {
+    if (requested != 0)
+        return requested;
+    unsigned hardware = std::thread::hardware_concurrency();
+    return hardware != 0 ? hardware : 1;
+}
+
+// Contiguous indices still to be run by one worker of ParallelFor. The owner
+// takes indices from the front; idle workers steal the back half.
+struct WorkRange {
+    std::mutex mutex;
+    size_t begin;
+    size_t end;
+    // Keeps ranges of different workers on separate cache lines.
+    char padding[64];
+
+    bool TakeFront(size_t& i) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (begin == end)
+            return false;
+        i = begin++;
+        return true;
+    }
+    size_t Remaining() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return end - begin;
+    }
+};
+
+// Runs body(worker, 0), ..., body(worker, count - 1) on up to `threads`
+// threads. `worker` identifies the calling thread as 0, ..., threads - 1, so
+// bodies can keep per-thread state. Each worker starts with a contiguous
+// share of the indices and runs it front to back; once done it steals the
+// back half of the largest remaining share. If any calls throw, the
+// exception from the lowest failing index is rethrown once all started calls
+// have returned; indices above a known failure are skipped.
+inline void ParallelFor(size_t count, unsigned threads, const std::function<void(unsigned, size_t)>& body) {
+    threads = std::min<size_t>(ThreadCount(threads), count);
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i)
+            body(0, i);
+        return;
+    }
+
+    std::unique_ptr<WorkRange[]> ranges(new WorkRange[threads]);
+    for (unsigned t = 0; t < threads; ++t) {
+        ranges[t].begin = count * t / threads;
+        ranges[t].end = count * (t + 1) / threads;
+    }
+
+    auto take = [&](unsigned worker, size_t& i) {
+        if (ranges[worker].TakeFront(i))
+            return true;
+        for (;;) {
+            unsigned victim = worker;
+            size_t most = 0;
+            for (unsigned t = 0; t < threads; ++t) {
+                size_t remaining = ranges[t].Remaining();
+                if (remaining > most) {
+                    victim = t;
+                    most = remaining;
+                }
+            }
+            if (most == 0)
+                return false;
+
+            size_t stolenBegin, stolenEnd;
+            {
+                std::lock_guard<std::mutex> lock(ranges[victim].mutex);
+                size_t remaining = ranges[victim].end - ranges[victim].begin;
+                if (remaining == 0)
+                    continue;
+                stolenEnd = ranges[victim].end;
+                stolenBegin = stolenEnd - (remaining + 1) / 2;
+                ranges[victim].end = stolenBegin;
+            }
+            std::lock_guard<std::mutex> lock(ranges[worker].mutex);
+            ranges[worker].begin = stolenBegin + 1;
+            ranges[worker].end = stolenEnd;
+            i = stolenBegin;
+            return true;
+        }
+    };
+
+    std::atomic<size_t> failedIndex{ count };
+    vector<std::exception_ptr> errors(count);
+
+    auto worker = [&](unsigned worker) {
+        size_t i;
+        while (take(worker, i)) {
+            if (i > failedIndex)
+                continue;
+            try {
+                body(worker, i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+                size_t failed = failedIndex;
+                while (i < failed && !failedIndex.compare_exchange_weak(failed, i)) {}
+            }
+        }
+    };
+
+    vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t)
+        pool.emplace_back(worker, t);
+    worker(0);
+    for (auto& thread : pool)
+        thread.join();
+
+    if (failedIndex < count)
+        std::rethrow_exception(errors[failedIndex]);
+}
+
+inline void ParallelFor(size_t count, unsigned threads, const std::function<void(size_t)>& body) {
+    ParallelFor(count, threads, [&](unsigned, size_t i) { body(i); });
+}
@@ -13,9 +13,13 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <queue>
+#include <random>
 #include <chrono>
 #include <fstream>
 #include <limits>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 using std::string;
 using std::cout;
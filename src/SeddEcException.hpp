@@ -4,7 +4,10 @@
 
 #define EXCEPTION_REASON_TABLE \
 X(LOGIC_ERROR) \
-X(INVALID_INPUT_FORMAT) 
+X(INVALID_INPUT_FORMAT) \
+X(IO_ERROR) \
+X(UNCOVERABLE_EVENT) \
+X(UNSUPPORTED_INPUT) 
 
 #define X(a) a,
 enum Reason {
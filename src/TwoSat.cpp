@@ -0,0 +1,51 @@
+#include "Pch.hpp"
+#include "TwoSat.hpp"
+
+TwoSat::TwoSat(unsigned variables, const vector<pair<Literal, Literal>>& clauses) :
+        offsets_(2 * variables + 1, 0), value_(variables, UNASSIGNED) {
+    // Clause a or b gives the implications !a -> b and !b -> a.
+    for (auto& clause : clauses) {
+        ++offsets_[Negate(clause.first) + 1];
+        ++offsets_[Negate(clause.second) + 1];
+    }
+    for (unsigned lit = 0; lit < 2 * variables; ++lit)
+        offsets_[lit + 1] += offsets_[lit];
+
+    implied_.resize(offsets_.back());
+    vector<unsigned> fill(begin(offsets_), end(offsets_) - 1);
+    for (auto& clause : clauses) {
+        implied_[fill[Negate(clause.first)]++] = clause.second;
+        implied_[fill[Negate(clause.second)]++] = clause.first;
+    }
+}
+
+bool TwoSat::Assume(Literal lit) {
+    if (IsTrue(lit))
+        return true;
+    if (IsFalse(lit))
+        return false;
+
+    size_t next = trail_.size();
+    value_[lit >> 1] = ValueOf(lit);
+    trail_.push_back(lit);
+    for (; next < trail_.size(); ++next) {
+        Literal current = trail_[next];
+        for (unsigned k = offsets_[current]; k < offsets_[current + 1]; ++k) {
+            Literal implied = implied_[k];
+            if (IsTrue(implied))
+                continue;
+            if (IsFalse(implied))
+                return false;
+            value_[implied >> 1] = ValueOf(implied);
+            trail_.push_back(implied);
+        }
+    }
+    return true;
+}
+
+void TwoSat::Backtrack(size_t trailSize) {
+    while (trail_.size() > trailSize) {
+        value_[trail_.back() >> 1] = UNASSIGNED;
+        trail_.pop_back();
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+// The implication graph of a 2-CNF formula over variables 0, ..., n - 1,
+// with assumptions decided by unit propagation. Variable v has the literals
+// 2v (true) and 2v + 1 (false). Propagation from a set of literals conflicts
+// iff the formula has no model containing them, provided the formula
+// without assumptions is satisfiable.
+class TwoSat {
+public:
+    typedef unsigned Literal;
+
+    static Literal Positive(unsigned var) { return 2 * var; }
+    static Literal Negative(unsigned var) { return 2 * var + 1; }
+    static Literal Negate(Literal lit) { return lit ^ 1; }
+
+    // clauses are pairs of literals of which at least one must hold.
+    TwoSat(unsigned variables, const vector<pair<Literal, Literal>>& clauses);
+
+    // Makes lit true and propagates. Returns false on a conflict, in which
+    // case the caller must backtrack to a trail size taken before the call.
+    bool Assume(Literal lit);
+    size_t TrailSize() const { return trail_.size(); }
+    void Backtrack(size_t trailSize);
+
+    bool IsTrue(Literal lit) const { return value_[lit >> 1] == ValueOf(lit); }
+    bool IsFalse(Literal lit) const { return value_[lit >> 1] == ValueOf(Negate(lit)); }
+private:
+    enum Value : unsigned char { UNASSIGNED, TRUE_VALUE, FALSE_VALUE };
+    static Value ValueOf(Literal lit) { return lit & 1 ? FALSE_VALUE : TRUE_VALUE; }
+
+    // Literals implied by lit are implied_[offsets_[lit]] up to implied_[offsets_[lit + 1]].
+    vector<unsigned> offsets_;
+    vector<Literal> implied_;
+    vector<Value> value_;
+    vector<Literal> trail_;
+};
@@ -5,6 +5,21 @@
     std::ostringstream().seekp(0, std::ios_base::cur) << ITEMS) \
     ).str())
 
+// A non-owning range over contiguous elements, e.g. one row of a CSR array.
+template<class T>
+class Span {
+public:
+    Span(const T* begin, const T* end) : begin_(begin), end_(end) {}
+    const T* begin() const { return begin_; }
+    const T* end() const { return end_; }
+    size_t size() const { return end_ - begin_; }
+    bool empty() const { return begin_ == end_; }
+    const T& operator[](size_t i) const { return begin_[i]; }
+private:
+    const T* begin_;
+    const T* end_;
+};
+
 // make_unique from https://isocpp.org/files/papers/N3656.txt
 //#include <cstddef>
 //#include <memory>
@@ -16,6 +16,13 @@ inline bool IsSatisfiable(expr term) {
     return s.check() == sat;
 }
 
+// Copies term into the target context, which must differ from its own.
+inline expr Translate(expr term, context& target) {
+    expr r{ target, Z3_translate(term.ctx(), term, target) };
+    term.check_error();
+    return r;
+}
+
 template<class T>
 ast_vector_tpl<T> ToZ3Vec(const vector<T> from, context& ctx) {
     ast_vector_tpl<T> to{ctx};
@@ -24,6 +31,31 @@ ast_vector_tpl<T> ToZ3Vec(const vector<T> from, context& ctx) {
     return to;
 }
 
+// Dense indices for a list of constants, keyed by their declarations, so
+// that a model can be read in one pass over its assignments instead of one
+// evaluation per constant.
+class ConstIndex {
+    unordered_map<unsigned, unsigned> indices_;
+
+public:
+    ConstIndex() {}
+    explicit ConstIndex(const vector<expr>& constants) {
+        for (unsigned i = 0; i < constants.size(); ++i)
+            indices_.emplace(Z3_get_func_decl_id(constants[i].ctx(), constants[i].decl()), i);
+    }
+
+    // Calls f(i) for every constant i that model assigns true.
+    template<class F>
+    void ForEachTrue(const model& model, F f) const {
+        for (unsigned k = 0; k < model.num_consts(); ++k) {
+            func_decl decl = model.get_const_decl(k);
+            auto index = indices_.find(Z3_get_func_decl_id(decl.ctx(), decl));
+            if (index != indices_.end() && Z3_get_bool_value(decl.ctx(), model.get_const_interp(decl)) == Z3_L_TRUE)
+                f(index->second);
+        }
+    }
+};
+
 struct Z3Hash {
     template<class T>
     size_t operator()(const T& x) const {
@@ -38,6 +70,26 @@ struct Z3Eq {
     }
 };
 
+inline expr MkAnd(expr_vector terms) {
+    array<Z3_ast> _terms(terms.size());
+    for (unsigned i = 0; i < terms.size(); ++i) {
+        _terms[i] = terms[i];
+    }
+    expr r{ terms.ctx(), Z3_mk_and(terms.ctx(), terms.size(), _terms.ptr()) };
+    terms.check_error();
+    return r;
+}
+
+inline expr MkOr(expr_vector terms) {
+    array<Z3_ast> _terms(terms.size());
+    for (unsigned i = 0; i < terms.size(); ++i) {
+        _terms[i] = terms[i];
+    }
+    expr r{ terms.ctx(), Z3_mk_or(terms.ctx(), terms.size(), _terms.ptr()) };
+    terms.check_error();
+    return r;
+}
+
 inline expr MkAtMost(expr_vector vars, unsigned k) {
     array<Z3_ast> _vars(vars.size());
     for (unsigned i = 0; i < vars.size(); ++i) {
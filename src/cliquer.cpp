@@ -13,12 +13,18 @@
 #include <sys/time.h>
 #include <sys/times.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include "cliquer.h"
+#include "fixed_set.h"
 
 
 /* Default cliquer options */
 static clique_options clique_default_options_struct = {
-	reorder_by_default, NULL, clique_print_time, NULL, NULL, NULL, NULL, 0
+	reorder_by_default, NULL, clique_print_time, NULL, NULL, NULL, NULL, 0, 1
 };
 clique_options *clique_default_options=&clique_default_options_struct;
 
@@ -28,76 +34,165 @@ clique_options *clique_default_options=&clique_default_options_struct;
 #define DIV_DOWN(d,q) ((int)((d)/(q)))
 
 
-/* Global variables used: */
-/* These must be saved and restored in re-entrance. */
-static int *clique_size;      /* c[i] == max. clique size in {0,1,...,i-1} */
-static set_t current_clique;  /* Current clique being searched. */
-static set_t best_clique;     /* Largest/heaviest clique found so far. */
-static struct tms cputimer;      /* Timer for opts->time_function() */
-static struct timeval realtimer; /* Timer for opts->time_function() */
-static int clique_list_count=0;  /* No. of cliques in opts->clique_list[] */
-static int weight_multiplier=1;  /* Weights multiplied by this when passing
-				  * to time_function(). */
+/*
+ * State of one search.  Every API call owns its own, so independent
+ * searches may run concurrently on different threads.
+ */
+typedef struct _clique_search clique_search;
+struct _clique_search {
+	int *clique_size;      /* c[i] == max. clique size in {0,1,...,i-1} */
+	set_t current_clique;  /* Current clique being searched. */
+	set_t best_clique;     /* Largest/heaviest clique found so far. */
+	struct tms cputimer;      /* Timer for opts->time_function() */
+	struct timeval realtimer; /* Timer for opts->time_function() */
+	int clocks_per_sec;       /* As returned by sysconf(_SC_CLK_TCK) */
+	int clique_list_count;  /* No. of cliques in opts->clique_list[] */
+	int weight_multiplier;  /* Weights multiplied by this when passing
+				 * to time_function(). */
+	int level;              /* Re-entrance level passed to time_function() */
+
+	/* Arena of vertex tables of g->n ints, taken and returned in stack
+	 * order by the recursion.  Tables are table_stride ints apart in
+	 * chunks of SEARCH_ARENA_CHUNK, allocated as the recursion first
+	 * gets that deep. */
+	int **table_chunks;
+	int table_stride;
+	int table_count;
+};
 
-/* List cache (contains memory blocks of size g->n * sizeof(int)) */
-static int **temp_list=NULL;
-static int temp_count=0;
+/* Tables per chunk of the table arena. */
+#define SEARCH_ARENA_CHUNK 16
+
+/*
+ * How many searches are running on this thread, one inside the other
+ * through opts->user_function().  Only used for the level passed to
+ * time_function().
+ */
+static thread_local int entrance_level=0;
 
 
 /*
- * Macros for re-entrance.  ENTRANCE_SAVE() must be called immediately
- * after variable definitions, ENTRANCE_RESTORE() restores global
- * variables to original values.  entrance_level should be increased
- * and decreased accordingly.
+ * search_begin()
+ *
+ * Allocates the state for searching graph g and starts its clock.
+ * best_clique is left NULL for the weighted searches to allocate.
  */
-static int entrance_level=0;  /* How many levels for entrance have occurred? */
+static void search_begin(clique_search *search, graph_t *g,
+			 int weight_multiplier) {
+	search->clique_size=(int*)calloc(g->n, sizeof(int));
+	search->current_clique=set_new(g->n);
+	search->best_clique=NULL;
+	/* table allocated later */
+	/* At most g->n+2 tables are taken at once, and the chunk list
+	 * ends in NULL. */
+	search->table_chunks=(int**)calloc((g->n+2)/SEARCH_ARENA_CHUNK+2,
+					   sizeof(int *));
+	/* Each table starts on a cache line. */
+	search->table_stride=(g->n+15)/16*16;
+	search->table_count=0;
+	search->clique_list_count=0;
+	search->weight_multiplier=weight_multiplier;
+	search->level=++entrance_level;
+
+	search->clocks_per_sec=sysconf(_SC_CLK_TCK);
+	ASSERT(search->clocks_per_sec>0);
 
-#define ENTRANCE_SAVE() \
-int *old_clique_size = clique_size;                     \
-set_t old_current_clique = current_clique;              \
-set_t old_best_clique = best_clique;                    \
-int old_clique_list_count = clique_list_count;          \
-int old_weight_multiplier = weight_multiplier;          \
-int **old_temp_list = temp_list;                        \
-int old_temp_count = temp_count;                        \
-struct tms old_cputimer;                                \
-struct timeval old_realtimer;                           \
-memcpy(&old_cputimer,&cputimer,sizeof(struct tms));       \
-memcpy(&old_realtimer,&realtimer,sizeof(struct timeval));
+	/* "start clock" */
+	gettimeofday(&search->realtimer,NULL);
+	times(&search->cputimer);
+}
+
+/*
+ * search_end()
+ *
+ * Frees the state of a search.  Cliques that are returned to the caller
+ * must be taken out of current_clique/best_clique first.
+ */
+static void search_end(clique_search *search) {
+	int i;
 
-#define ENTRANCE_RESTORE() \
-clique_size = old_clique_size;                          \
-current_clique = old_current_clique;                    \
-best_clique = old_best_clique;                          \
-clique_list_count = old_clique_list_count;              \
-weight_multiplier = old_weight_multiplier;              \
-temp_list = old_temp_list;                              \
-temp_count = old_temp_count;                            \
-memcpy(&cputimer,&old_cputimer,sizeof(struct tms));       \
-memcpy(&realtimer,&old_realtimer,sizeof(struct timeval));
+	for (i=0; search->table_chunks[i]; i++)
+		free(search->table_chunks[i]);
+	free(search->table_chunks);
+	free(search->clique_size);
+	if (search->current_clique)
+		set_free(search->current_clique);
+	if (search->best_clique)
+		set_free(search->best_clique);
+	entrance_level--;
+}
 
+/*
+ * search_table_take()
+ *
+ * Returns a table of g->n ints from the arena of search, to be given
+ * back with search_table_return() before any table taken earlier.
+ */
+static int *search_table_take(clique_search *search) {
+	int **chunk;
+	int k;
+
+	k=search->table_count++;
+	chunk=&search->table_chunks[k/SEARCH_ARENA_CHUNK];
+	if (*chunk==NULL &&
+	    posix_memalign((void **)chunk,64,SEARCH_ARENA_CHUNK*
+			   search->table_stride*sizeof(int))!=0) {
+		fprintf(stderr,"Out of memory in clique search.\n");
+		abort();
+	}
+	return *chunk+(k%SEARCH_ARENA_CHUNK)*search->table_stride;
+}
 
-/* Number of clock ticks per second (as returned by sysconf(_SC_CLK_TCK)) */
-static int clocks_per_sec=0;
+/*
+ * search_table_return()
+ *
+ * Gives back table, the last table taken from the arena of search.
+ */
+static void search_table_return(clique_search *search, int *table) {
+	search->table_count--;
+	ASSERT(table==search->table_chunks[search->table_count/
+					   SEARCH_ARENA_CHUNK]+
+	       (search->table_count%SEARCH_ARENA_CHUNK)*search->table_stride);
+}
 
 
 
 
 /* Recursion and helper functions */
-static boolean sub_unweighted_single(int *table, int size, int min_size,
+template<int N>
+static int fixed_unweighted_search_single(clique_search *search,
+					  int *table, int min_size,
+					  graph_t *g, clique_options *opts);
+static int parallel_unweighted_search_single(clique_search *search,
+					     int *table, int min_size,
+					     graph_t *g, clique_options *opts);
+static boolean sub_unweighted_single(clique_search *search,
+				     int *table, int size, int min_size,
 				     graph_t *g);
-static int sub_unweighted_all(int *table, int size, int min_size, int max_size,
+static int sub_unweighted_all(clique_search *search,
+			      int *table, int size, int min_size, int max_size,
 			      boolean maximal, graph_t *g,
 			      clique_options *opts);
-static int sub_weighted_all(int *table, int size, int weight,
+static int sub_weighted_all(clique_search *search,
+			    int *table, int size, int weight,
 			    int current_weight, int prune_low, int prune_high,
 			    int min_weight, int max_weight, boolean maximal,
 			    graph_t *g, clique_options *opts);
 
 
-static boolean store_clique(set_t clique, graph_t *g, clique_options *opts);
-static boolean is_maximal(set_t clique, graph_t *g);
+static boolean search_time_function(clique_search *search, int i,
+				    graph_t *g, int max,
+				    clique_options *opts);
+static boolean store_clique(clique_search *search,
+			    set_t clique, graph_t *g, clique_options *opts);
+static boolean is_maximal(clique_search *search, set_t clique, graph_t *g);
 static boolean false_function(set_t clique,graph_t *g,clique_options *opts);
+static set_t unweighted_find_single(graph_t *g,int min_size,int max_size,
+				    boolean maximal, clique_options *opts,
+				    int weight_multiplier);
+static int unweighted_find_all(graph_t *g, int min_size, int max_size,
+			       boolean maximal, clique_options *opts,
+			       int weight_multiplier);
 
 
 
@@ -136,28 +231,39 @@ static boolean false_function(set_t clique,graph_t *g,clique_options *opts);
  *
  * Note: Does NOT use opts->user_function of opts->clique_list.
  */
-static int unweighted_clique_search_single(int *table, int min_size,
+static int unweighted_clique_search_single(clique_search *search,
+					   int *table, int min_size,
 					   graph_t *g, clique_options *opts) {
-	struct tms tms;
-	struct timeval timeval;
 	int i,j;
 	int v,w;
 	int *newtable;
 	int newsize;
 
 	v=table[0];
-	clique_size[v]=1;
-	set_empty(current_clique);
-	SET_ADD_ELEMENT(current_clique,v);
+	search->clique_size[v]=1;
+	set_empty(search->current_clique);
+	SET_ADD_ELEMENT(search->current_clique,v);
 	if (min_size==1)
 		return 1;
 
-	if (temp_count) {
-		temp_count--;
-		newtable=temp_list[temp_count];
-	} else {
-		newtable=(int*)malloc(g->n * sizeof(int));
-	}
+	/* Graphs that fit a fixed_set are searched with one. */
+	if (g->n <= 64)
+		return fixed_unweighted_search_single<64>(search,table,min_size,
+							  g,opts);
+	if (g->n <= 128)
+		return fixed_unweighted_search_single<128>(search,table,min_size,
+							   g,opts);
+	if (g->n <= 256)
+		return fixed_unweighted_search_single<256>(search,table,min_size,
+							   g,opts);
+	if (g->n <= 512)
+		return fixed_unweighted_search_single<512>(search,table,min_size,
+							   g,opts);
+	if (opts && opts->threads > 1)
+		return parallel_unweighted_search_single(search,table,min_size,
+							 g,opts);
+
+	newtable=search_table_take(search);
 	for (i=1; i < g->n; i++) {
 		w=v;
 		v=table[i];
@@ -170,49 +276,524 @@ static int unweighted_clique_search_single(int *table, int min_size,
 			}
 		}
 
-		if (sub_unweighted_single(newtable,newsize,clique_size[w],g)) {
-			SET_ADD_ELEMENT(current_clique,v);
-			clique_size[v]=clique_size[w]+1;
+		if (sub_unweighted_single(search,newtable,newsize,search->clique_size[w],g)) {
+			SET_ADD_ELEMENT(search->current_clique,v);
+			search->clique_size[v]=search->clique_size[w]+1;
 		} else {
-			clique_size[v]=clique_size[w];
+			search->clique_size[v]=search->clique_size[w];
 		}
 
-		if (opts && opts->time_function) {
-			gettimeofday(&timeval,NULL);
-			times(&tms);
-			if (!opts->time_function(entrance_level,
-						 i+1,g->n,clique_size[v] *
-						 weight_multiplier,
-						 (double)(tms.tms_utime-
-							  cputimer.tms_utime)/
-						 clocks_per_sec,
-						 timeval.tv_sec-
-						 realtimer.tv_sec+
-						 (double)(timeval.tv_usec-
-							  realtimer.tv_usec)/
-						 1000000,opts)) {
-				temp_list[temp_count++]=newtable;
+		if (!search_time_function(search,i+1,g,search->clique_size[v],
+					  opts)) {
+			search_table_return(search,newtable);
+			return 0;
+		}
+
+		if (min_size) {
+			if (search->clique_size[v]>=min_size) {
+				search_table_return(search,newtable);
+				return search->clique_size[v];
+			}
+			if (search->clique_size[v]+g->n-i-1 < min_size) {
+				search_table_return(search,newtable);
 				return 0;
 			}
 		}
+	}
+
+	search_table_return(search,newtable);
+
+	if (min_size)
+		return 0;
+	return search->clique_size[v];
+}
+
+/*
+ * State of fixed_unweighted_search_single().  Vertices are numbered by
+ * their position in table, so each vertex table of the search above
+ * becomes a fixed_set holding the same vertices in the same order.
+ */
+template<int N>
+struct fixed_search {
+	clique_search *search;
+	int *table;
+	fixed_set<N> adj[N];   /* Neighbours of each position */
+	int clique_size[N];    /* clique_size[] by position */
+};
+
+/*
+ * sub_fixed_single()
+ *
+ * sub_unweighted_single() on the vertices of set.  set doubles as the
+ * table: removing its last vertex leaves the ones before it.
+ */
+template<int N>
+static boolean sub_fixed_single(fixed_search<N> *fs, fixed_set<N> set,
+				int size, int min_size) {
+	clique_search *search=fs->search;
+	fixed_set<N> newset;
+	int newsize;
+	int i;
+	int v;
+
+	/* Zero or one vertices needed anymore. */
+	if (min_size <= 1) {
+		if (size>0 && min_size==1) {
+			set_empty(search->current_clique);
+			SET_ADD_ELEMENT(search->current_clique,
+					fs->table[fixed_set_first(set)]);
+			return TRUE;
+		}
+		if (min_size==0) {
+			set_empty(search->current_clique);
+			return TRUE;
+		}
+		return FALSE;
+	}
+	if (size < min_size)
+		return FALSE;
+
+	for (i = size-1; i >= 0; i--) {
+		v = fixed_set_last(set);
+
+		if (fs->clique_size[v] < min_size)
+			break;
+		if (i+1 < min_size)
+			break;
+
+		fixed_set_del(set,v);
+		newset=fixed_set_intersection(set,fs->adj[v]);
+		newsize=fixed_set_size(newset);
+
+		if (newsize < min_size-1)
+			continue;
+		if (fs->clique_size[fixed_set_last(newset)] < min_size-1)
+			continue;
+
+		if (sub_fixed_single(fs,newset,newsize,min_size-1)) {
+			/* Clique found. */
+			SET_ADD_ELEMENT(search->current_clique,fs->table[v]);
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/*
+ * One base-level step of parallel_unweighted_search_single(): whether
+ * a clique of size target exists among the earlier neighbours of the
+ * base vertex.
+ */
+typedef struct _base_step base_step;
+struct _base_step {
+	std::atomic<bool> done;
+	int target;
+	boolean found;
+	set_t clique;     /* The clique found, without the base vertex */
+};
+
+/*
+ * State shared by the threads of parallel_unweighted_search_single().
+ */
+typedef struct _parallel_search parallel_search;
+typedef struct _step_runner step_runner;
+struct _parallel_search {
+	clique_search *search;
+	int *table;
+	int min_size;
+	graph_t *g;
+	clique_options *opts;
+	const step_runner *runner;   /* Searches the steps */
+	void *shared;                /* Read-only state of runner */
+
+	base_step *steps;
+	int window;                  /* Steps in flight past the final ones */
+	std::atomic<int> next;       /* Next step to claim */
+	std::atomic<int> committed;  /* Steps below this are final */
+	std::atomic<int> best;       /* clique_size[] of the last final step */
+	std::atomic<bool> stop;
+	std::mutex commit_mutex;     /* Held while committing steps */
+	std::condition_variable progress;  /* Signalled on commit and stop */
+	int result;
+};
+
+/*
+ * How the threads of a parallel_search search a base-level step.
+ *
+ *   begin - returns the scratch state of a thread searching with local
+ *   run   - looks for a clique of size target among the earlier
+ *           neighbours of table[i], leaving it in local->current_clique.
+ *           clique_size[] is final for the first k vertices of table,
+ *           and the later ones are given the bound of last plus one per
+ *           vertex past vertex k-1.
+ *   end   - frees the scratch state
+ */
+struct _step_runner {
+	void *(*begin)(parallel_search *ps, clique_search *local);
+	boolean (*run)(parallel_search *ps, clique_search *local, void *state,
+		       int i, int k, int last, int target);
+	void (*end)(clique_search *local, void *state);
+};
+
+/*
+ * Steps searched with sub_unweighted_single() on vertex tables.
+ */
+static void *table_step_begin(parallel_search *ps, clique_search *local) {
+	return search_table_take(local);
+}
+
+static boolean table_step_run(parallel_search *ps, clique_search *local,
+			      void *state, int i, int k, int last,
+			      int target) {
+	clique_search *search=ps->search;
+	graph_t *g=ps->g;
+	int *table=ps->table;
+	int *newtable=(int *)state;
+	int newsize;
+	int j,v;
+
+	v=table[i];
+	newsize=0;
+	for (j=0; j<i; j++) {
+		if (GRAPH_IS_EDGE(g, v, table[j])) {
+			newtable[newsize]=table[j];
+			newsize++;
+			local->clique_size[table[j]] = (j < k) ?
+				search->clique_size[table[j]] :
+				last+j-k+1;
+		}
+	}
+	return sub_unweighted_single(local,newtable,newsize,target,g);
+}
+
+static void table_step_end(clique_search *local, void *state) {
+	search_table_return(local,(int *)state);
+}
+
+static const step_runner table_steps = {
+	table_step_begin, table_step_run, table_step_end
+};
+
+/*
+ * commit_steps()
+ *
+ * Makes the finished steps following the last final one final, in
+ * order, exactly as unweighted_clique_search_single() would have taken
+ * them.  A step that found a clique while looking for a smaller one
+ * than the final clique_size[] of the previous vertex asks for is run
+ * again with the exact size.  A step that found none needs no rerun:
+ * no larger clique can then exist either.
+ *
+ *   local - search state of the calling thread
+ *   state - scratch state of ps->runner for local
+ */
+static void commit_steps(parallel_search *ps, clique_search *local,
+			 void *state) {
+	clique_search *search=ps->search;
+	clique_options *opts=ps->opts;
+	graph_t *g=ps->g;
+	int *table=ps->table;
+	base_step *step;
+	int i;
+	int v,m;
+
+	std::lock_guard<std::mutex> lock(ps->commit_mutex);
+	for (;;) {
+		i=ps->committed.load(std::memory_order_relaxed);
+		if (i >= g->n || ps->stop.load(std::memory_order_relaxed))
+			return;
+		step=&ps->steps[i];
+		if (!step->done.load(std::memory_order_acquire))
+			return;
+
+		v=table[i];
+		m=search->clique_size[table[i-1]];
+		if (step->found && step->target < m) {
+			set_free(step->clique);
+			step->clique=NULL;
+			step->found=ps->runner->run(ps,local,state,i,i,m,m);
+			if (step->found)
+				step->clique=set_duplicate(local->current_clique);
+		}
+
+		if (step->found) {
+			set_copy(search->current_clique,step->clique);
+			SET_ADD_ELEMENT(search->current_clique,v);
+			set_free(step->clique);
+			step->clique=NULL;
+			search->clique_size[v]=m+1;
+		} else {
+			search->clique_size[v]=m;
+		}
+		ps->committed.store(i+1,std::memory_order_release);
+		ps->best.store(search->clique_size[v],std::memory_order_relaxed);
+
+		if (!search_time_function(search,i+1,g,search->clique_size[v],
+					  opts)) {
+			ps->result=0;
+			ps->stop=true;
+			break;
+		}
+
+		if (ps->min_size) {
+			if (search->clique_size[v]>=ps->min_size) {
+				ps->result=search->clique_size[v];
+				ps->stop=true;
+				break;
+			}
+			if (search->clique_size[v]+g->n-i-1 < ps->min_size) {
+				ps->result=0;
+				ps->stop=true;
+				break;
+			}
+		}
+		ps->progress.notify_all();
+	}
+	ps->progress.notify_all();
+}
+
+/*
+ * parallel_worker()
+ *
+ * Claims base-level steps in order, at most ps->window past the last
+ * final one, and runs them speculatively.  The size looked for is the
+ * best one final so far, which the final clique_size[] of the previous
+ * vertex can only exceed.  Vertices not yet final get the upper bound
+ * of growing by one per step past the last final one, so the pruning
+ * of the step search stays sound and finds the same clique as with the
+ * exact sizes.  Far ahead these bounds hardly prune at all,
+ * hence the window.
+ */
+static void parallel_worker(parallel_search *ps) {
+	clique_search *search=ps->search;
+	graph_t *g=ps->g;
+	int *table=ps->table;
+	clique_search local;
+	base_step *step;
+	void *state;
+	int i,k;
+	int last,target;
+
+	search_begin(&local,g,search->weight_multiplier);
+	state=ps->runner->begin(ps,&local);
+
+	while (!ps->stop.load(std::memory_order_relaxed)) {
+		i=ps->next++;
+		if (i >= g->n)
+			break;
+		if (i >= ps->committed.load(std::memory_order_relaxed)+ps->window) {
+			std::unique_lock<std::mutex> lock(ps->commit_mutex);
+			ps->progress.wait(lock,[ps,i]() {
+				return ps->stop.load(std::memory_order_relaxed) ||
+					i < ps->committed.load(std::memory_order_relaxed)+
+					ps->window;
+			});
+			if (ps->stop.load(std::memory_order_relaxed))
+				break;
+		}
+
+		k=ps->committed.load(std::memory_order_acquire);
+		last=search->clique_size[table[k-1]];
+		target=ps->best.load(std::memory_order_relaxed);
+		if (target < last)
+			target=last;
+
+		step=&ps->steps[i];
+		step->target=target;
+		step->found=ps->runner->run(ps,&local,state,i,k,last,target);
+		step->clique=step->found ?
+			set_duplicate(local.current_clique) : NULL;
+		step->done.store(true,std::memory_order_release);
+
+		commit_steps(ps,&local,state);
+	}
+
+	ps->runner->end(&local,state);
+	search_end(&local);
+}
+
+/*
+ * parallel_search_run()
+ *
+ * As unweighted_clique_search_single(), with the base-level steps
+ * searched by runner and spread over opts->threads threads.  Returns
+ * the same value and leaves the same clique in current_clique and the
+ * same clique_size[] behind.  table[0] must already be set up by the
+ * caller.
+ */
+static int parallel_search_run(clique_search *search, int *table,
+			       int min_size, graph_t *g, clique_options *opts,
+			       const step_runner *runner, void *shared) {
+	parallel_search ps;
+	std::thread *threads;
+	int count;
+	int i;
+
+	count=MIN(opts->threads,g->n-1);
+	ps.search=search;
+	ps.table=table;
+	ps.min_size=min_size;
+	ps.g=g;
+	ps.opts=opts;
+	ps.runner=runner;
+	ps.shared=shared;
+	ps.steps=new base_step[g->n];
+	ps.window=count;
+	for (i=0; i < g->n; i++) {
+		ps.steps[i].done=false;
+		ps.steps[i].clique=NULL;
+	}
+	ps.next=1;
+	ps.committed=1;
+	ps.best=1;
+	ps.stop=false;
+	ps.result=min_size ? 0 : -1;
+
+	threads=new std::thread[count-1];
+	for (i=0; i < count-1; i++)
+		threads[i]=std::thread(parallel_worker,&ps);
+	parallel_worker(&ps);
+	for (i=0; i < count-1; i++)
+		threads[i].join();
+	delete[] threads;
+
+	for (i=0; i < g->n; i++)
+		if (ps.steps[i].clique)
+			set_free(ps.steps[i].clique);
+	delete[] ps.steps;
+
+	if (ps.result < 0)
+		return search->clique_size[table[g->n-1]];
+	return ps.result;
+}
+
+/*
+ * parallel_unweighted_search_single()
+ *
+ * parallel_search_run() on vertex tables, for graphs of any size.
+ */
+static int parallel_unweighted_search_single(clique_search *search,
+					     int *table, int min_size,
+					     graph_t *g, clique_options *opts) {
+	return parallel_search_run(search,table,min_size,g,opts,
+				   &table_steps,NULL);
+}
+
+/*
+ * Steps searched with sub_fixed_single().  Each thread has a copy of the
+ * fixed_search shared by the caller, with clique_size[] of its own.
+ */
+template<int N>
+static void *fixed_step_begin(parallel_search *ps, clique_search *local) {
+	fixed_search<N> *fs;
+
+	fs=new fixed_search<N>(*(fixed_search<N> *)ps->shared);
+	fs->search=local;
+	return fs;
+}
+
+template<int N>
+static boolean fixed_step_run(parallel_search *ps, clique_search *local,
+			      void *state, int i, int k, int last,
+			      int target) {
+	fixed_search<N> *fs=(fixed_search<N> *)state;
+	fixed_set<N> set;
+	int j;
+
+	for (j=0; j<i; j++)
+		fs->clique_size[j] = (j < k) ?
+			ps->search->clique_size[ps->table[j]] :
+			last+j-k+1;
+	set=fixed_set_intersection(fs->adj[i],fixed_set_below<N>(i));
+	return sub_fixed_single(fs,set,fixed_set_size(set),target);
+}
+
+template<int N>
+static void fixed_step_end(clique_search *local, void *state) {
+	delete (fixed_search<N> *)state;
+}
+
+template<int N>
+static const step_runner *fixed_step_runner() {
+	static const step_runner runner = {
+		fixed_step_begin<N>, fixed_step_run<N>, fixed_step_end<N>
+	};
+	return &runner;
+}
+
+/*
+ * fixed_unweighted_search_single()
+ *
+ * As unweighted_clique_search_single(), for graphs of at most N
+ * vertices.  Finds the same cliques, as it looks through the same
+ * vertices in the same order, with the base-level steps on
+ * opts->threads threads if there are several.  table[0] must already be
+ * set up by the caller.
+ */
+template<int N>
+static int fixed_unweighted_search_single(clique_search *search,
+					  int *table, int min_size,
+					  graph_t *g, clique_options *opts) {
+	fixed_search<N> *fs;
+	fixed_set<N> set;
+	int *position;
+	int i,j;
+	int size;
+
+	fs=new fixed_search<N>;
+	fs->search=search;
+	fs->table=table;
+	position=(int*)malloc(g->n * sizeof(int));
+	for (i=0; i < g->n; i++)
+		position[table[i]]=i;
+	for (i=0; i < g->n; i++) {
+		fs->adj[i]=fixed_set_empty<N>();
+		j=-1;
+		while ((j=set_return_next(g->edges[table[i]],j))>=0)
+			fixed_set_add(fs->adj[i],position[j]);
+	}
+	free(position);
+
+	if (opts && opts->threads > 1) {
+		size=parallel_search_run(search,table,min_size,g,opts,
+					 fixed_step_runner<N>(),fs);
+		delete fs;
+		return size;
+	}
+
+	size=1;
+	fs->clique_size[0]=size;
+	for (i=1; i < g->n; i++) {
+		set=fixed_set_intersection(fs->adj[i],fixed_set_below<N>(i));
+		size=fs->clique_size[i-1];
+		if (sub_fixed_single(fs,set,fixed_set_size(set),size)) {
+			SET_ADD_ELEMENT(search->current_clique,table[i]);
+			size++;
+		}
+		fs->clique_size[i]=size;
+		search->clique_size[table[i]]=size;
+
+		if (!search_time_function(search,i+1,g,size,opts)) {
+			delete fs;
+			return 0;
+		}
 
 		if (min_size) {
-			if (clique_size[v]>=min_size) {
-				temp_list[temp_count++]=newtable;
-				return clique_size[v];
+			if (size>=min_size) {
+				delete fs;
+				return size;
 			}
-			if (clique_size[v]+g->n-i-1 < min_size) {
-				temp_list[temp_count++]=newtable;
+			if (size+g->n-i-1 < min_size) {
+				delete fs;
 				return 0;
 			}
 		}
 	}
 
-	temp_list[temp_count++]=newtable;
-
+	delete fs;
 	if (min_size)
 		return 0;
-	return clique_size[v];
+	return size;
 }
 
 /*
@@ -232,7 +813,8 @@ static int unweighted_clique_search_single(int *table, int min_size,
  * clique_size[] for all values in table must be defined and correct,
  * otherwise inaccurate results may occur.
  */
-static boolean sub_unweighted_single(int *table, int size, int min_size,
+static boolean sub_unweighted_single(clique_search *search,
+				     int *table, int size, int min_size,
 				     graph_t *g) {
 	int i;
 	int v;
@@ -242,12 +824,12 @@ static boolean sub_unweighted_single(int *table, int size, int min_size,
 	/* Zero or one vertices needed anymore. */
 	if (min_size <= 1) {
 		if (size>0 && min_size==1) {
-			set_empty(current_clique);
-			SET_ADD_ELEMENT(current_clique,table[0]);
+			set_empty(search->current_clique);
+			SET_ADD_ELEMENT(search->current_clique,table[0]);
 			return TRUE;
 		}
 		if (min_size==0) {
-			set_empty(current_clique);
+			set_empty(search->current_clique);
 			return TRUE;
 		}
 		return FALSE;
@@ -256,17 +838,12 @@ static boolean sub_unweighted_single(int *table, int size, int min_size,
 		return FALSE;
 
 	/* Dynamic memory allocation with cache */
-	if (temp_count) {
-		temp_count--;
-		newtable=temp_list[temp_count];
-	} else {
-		newtable=(int*)malloc(g->n * sizeof(int));
-	}
+	newtable=search_table_take(search);
 
 	for (i = size-1; i >= 0; i--) {
 		v = table[i];
 
-		if (clique_size[v] < min_size)
+		if (search->clique_size[v] < min_size)
 			break;
 		/* This is faster when compiling with gcc than placing
 		 * this in the for-loop condition. */
@@ -288,18 +865,18 @@ static boolean sub_unweighted_single(int *table, int size, int min_size,
 			continue;
 		/* Now p1-newtable >= min_size-1 >= 2-1 == 1, so we can use
 		 * p1-newtable-1 safely. */
-		if (clique_size[newtable[p1-newtable-1]] < min_size-1)
+		if (search->clique_size[newtable[p1-newtable-1]] < min_size-1)
 			continue;
 
-		if (sub_unweighted_single(newtable,p1-newtable,
+		if (sub_unweighted_single(search,newtable,p1-newtable,
 					  min_size-1,g)) {
 			/* Clique found. */
-			SET_ADD_ELEMENT(current_clique,v);
-			temp_list[temp_count++]=newtable;
+			SET_ADD_ELEMENT(search->current_clique,v);
+			search_table_return(search,newtable);
 			return TRUE;
 		}
 	}
-	temp_list[temp_count++]=newtable;
+	search_table_return(search,newtable);
 	return FALSE;
 }
 
@@ -330,7 +907,8 @@ static boolean sub_unweighted_single(int *table, int size, int min_size,
  * Returns the number of cliques stored (not neccessarily number of cliques
  * in graph, if user/time_function aborts).
  */
-static int unweighted_clique_search_all(int *table, int start,
+static int unweighted_clique_search_all(clique_search *search,
+					int *table, int start,
 					int min_size, int max_size,
 					boolean maximal, graph_t *g,
 					clique_options *opts) {
@@ -342,18 +920,13 @@ static int unweighted_clique_search_all(int *table, int start,
 	int newsize;
 	int count=0;
 
-	if (temp_count) {
-		temp_count--;
-		newtable=temp_list[temp_count];
-	} else {
-		newtable=(int*)malloc(g->n * sizeof(int));
-	}
+	newtable=search_table_take(search);
 
-	clique_list_count=0;
-	set_empty(current_clique);
+	search->clique_list_count=0;
+	set_empty(search->current_clique);
 	for (i=start; i < g->n; i++) {
 		v=table[i];
-		clique_size[v]=min_size;  /* Do not prune here. */
+		search->clique_size[v]=min_size;  /* Do not prune here. */
 
 		newsize=0;
 		for (j=0; j<i; j++) {
@@ -363,10 +936,10 @@ static int unweighted_clique_search_all(int *table, int start,
 			}
 		}
 
-		SET_ADD_ELEMENT(current_clique,v);
-		j=sub_unweighted_all(newtable,newsize,min_size-1,max_size-1,
+		SET_ADD_ELEMENT(search->current_clique,v);
+		j=sub_unweighted_all(search,newtable,newsize,min_size-1,max_size-1,
 				     maximal,g,opts);
-		SET_DEL_ELEMENT(current_clique,v);
+		SET_DEL_ELEMENT(search->current_clique,v);
 		if (j<0) {
 			/* Abort. */
 			count-=j;
@@ -377,23 +950,23 @@ static int unweighted_clique_search_all(int *table, int start,
 		if (opts->time_function) {
 			gettimeofday(&timeval,NULL);
 			times(&tms);
-			if (!opts->time_function(entrance_level,
+			if (!opts->time_function(search->level,
 						 i+1,g->n,min_size *
-						 weight_multiplier,
+						 search->weight_multiplier,
 						 (double)(tms.tms_utime-
-							  cputimer.tms_utime)/
-						 clocks_per_sec,
+							  search->cputimer.tms_utime)/
+						 search->clocks_per_sec,
 						 timeval.tv_sec-
-						 realtimer.tv_sec+
+						 search->realtimer.tv_sec+
 						 (double)(timeval.tv_usec-
-							  realtimer.tv_usec)/
+							  search->realtimer.tv_usec)/
 						 1000000,opts)) {
 				/* Abort. */
 				break;
 			}
 		}
 	}
-	temp_list[temp_count++]=newtable;
+	search_table_return(search,newtable);
 	return count;
 }
 
@@ -422,7 +995,8 @@ static int unweighted_clique_search_all(int *table, int start,
  * clique_size[] for all values in table must be defined and correct,
  * otherwise inaccurate results may occur.
  */
-static int sub_unweighted_all(int *table, int size, int min_size, int max_size,
+static int sub_unweighted_all(clique_search *search,
+			      int *table, int size, int min_size, int max_size,
 			      boolean maximal, graph_t *g,
 			      clique_options *opts) {
 	int i;
@@ -433,10 +1007,10 @@ static int sub_unweighted_all(int *table, int size, int min_size, int max_size,
 	int count=0;     /* Amount of cliques found */
 
 	if (min_size <= 0) {
-		if ((!maximal) || is_maximal(current_clique,g)) {
+		if ((!maximal) || is_maximal(search,search->current_clique,g)) {
 			/* We've found one.  Store it. */
 			count++;
-			if (!store_clique(current_clique,g,opts)) {
+			if (!store_clique(search,search->current_clique,g,opts)) {
 				return -count;
 			}
 		}
@@ -451,16 +1025,11 @@ static int sub_unweighted_all(int *table, int size, int min_size, int max_size,
 	}
 
 	/* Dynamic memory allocation with cache */
-	if (temp_count) {
-		temp_count--;
-		newtable=temp_list[temp_count];
-	} else {
-		newtable=(int*)malloc(g->n * sizeof(int));
-	}
+	newtable=search_table_take(search);
 
 	for (i=size-1; i>=0; i--) {
 		v = table[i];
-		if (clique_size[v] < min_size) {
+		if (search->clique_size[v] < min_size) {
 			break;
 		}
 		if (i+1 < min_size) {
@@ -482,10 +1051,10 @@ static int sub_unweighted_all(int *table, int size, int min_size, int max_size,
 			continue;
 		}
 
-		SET_ADD_ELEMENT(current_clique,v);
-		n=sub_unweighted_all(newtable,p1-newtable,
+		SET_ADD_ELEMENT(search->current_clique,v);
+		n=sub_unweighted_all(search,newtable,p1-newtable,
 				     min_size-1,max_size-1,maximal,g,opts);
-		SET_DEL_ELEMENT(current_clique,v);
+		SET_DEL_ELEMENT(search->current_clique,v);
 		if (n < 0) {
 			/* Abort. */
 			count -= n;
@@ -494,7 +1063,7 @@ static int sub_unweighted_all(int *table, int size, int min_size, int max_size,
 		}
 		count+=n;
 	}
-	temp_list[temp_count++]=newtable;
+	search_table_return(search,newtable);
 	return count;
 }
 
@@ -535,7 +1104,8 @@ static int sub_unweighted_all(int *table, int size, int min_size, int max_size,
  *
  * Note: Does NOT use opts->user_function of opts->clique_list.
  */
-static int weighted_clique_search_single(int *table, int min_weight,
+static int weighted_clique_search_single(clique_search *search,
+					 int *table, int min_weight,
 					 int max_weight, graph_t *g,
 					 clique_options *opts) {
 	struct timeval timeval;
@@ -561,8 +1131,8 @@ static int weighted_clique_search_single(int *table, int min_weight,
 		 * We write nothing to clique_size[]. */
 		for (i=0; i < g->n; i++) {
 			if (g->weights[table[i]] <= max_weight) {
-				set_empty(best_clique);
-				SET_ADD_ELEMENT(best_clique,table[i]);
+				set_empty(search->best_clique);
+				SET_ADD_ELEMENT(search->best_clique,table[i]);
 				return g->weights[table[i]];
 			}
 		}
@@ -574,13 +1144,13 @@ static int weighted_clique_search_single(int *table, int min_weight,
 	localopts.reorder_map=NULL;
 	localopts.user_function=false_function;
 	localopts.user_data=NULL;
-	localopts.clique_list=&best_clique;
+	localopts.clique_list=&search->best_clique;
 	localopts.clique_list_length=1;
-	clique_list_count=0;
+	search->clique_list_count=0;
 
 	v=table[0];
-	set_empty(best_clique);
-	SET_ADD_ELEMENT(best_clique,v);
+	set_empty(search->best_clique);
+	SET_ADD_ELEMENT(search->best_clique,v);
 	search_weight=g->weights[v];
 	if (min_weight && (search_weight >= min_weight)) {
 		if (search_weight <= max_weight) {
@@ -589,15 +1159,10 @@ static int weighted_clique_search_single(int *table, int min_weight,
 		}
 		search_weight=min_weight-1;
 	}
-	clique_size[v]=search_weight;
-	set_empty(current_clique);
+	search->clique_size[v]=search_weight;
+	set_empty(search->current_clique);
 
-	if (temp_count) {
-		temp_count--;
-		newtable=temp_list[temp_count];
-	} else {
-		newtable=(int*)malloc(g->n * sizeof(int));
-	}
+	newtable=search_table_take(search);
 
 	for (i = 1; i < g->n; i++) {
 		v=table[i];
@@ -613,46 +1178,46 @@ static int weighted_clique_search_single(int *table, int min_weight,
 		}
 
 
-		SET_ADD_ELEMENT(current_clique,v);
-		search_weight=sub_weighted_all(newtable,newsize,newweight,
+		SET_ADD_ELEMENT(search->current_clique,v);
+		search_weight=sub_weighted_all(search,newtable,newsize,newweight,
 					       g->weights[v],search_weight,
-					       clique_size[table[i-1]] +
+					       search->clique_size[table[i-1]] +
 					       g->weights[v],
 					       min_w,max_weight,FALSE,
 					       g,&localopts);
-		SET_DEL_ELEMENT(current_clique,v);
+		SET_DEL_ELEMENT(search->current_clique,v);
 		if (search_weight < 0) {
 			break;
 		}
 
-		clique_size[v]=search_weight;
+		search->clique_size[v]=search_weight;
 
 		if (opts->time_function) {
 			gettimeofday(&timeval,NULL);
 			times(&tms);
-			if (!opts->time_function(entrance_level,
-						 i+1,g->n,clique_size[v] *
-						 weight_multiplier,
+			if (!opts->time_function(search->level,
+						 i+1,g->n,search->clique_size[v] *
+						 search->weight_multiplier,
 						 (double)(tms.tms_utime-
-							  cputimer.tms_utime)/
-						 clocks_per_sec,
+							  search->cputimer.tms_utime)/
+						 search->clocks_per_sec,
 						 timeval.tv_sec-
-						 realtimer.tv_sec+
+						 search->realtimer.tv_sec+
 						 (double)(timeval.tv_usec-
-							  realtimer.tv_usec)/
+							  search->realtimer.tv_usec)/
 						 1000000,opts)) {
-				set_free(current_clique);
-				current_clique=NULL;
+				set_free(search->current_clique);
+				search->current_clique=NULL;
 				break;
 			}
 		}
 	}
-	temp_list[temp_count++]=newtable;
+	search_table_return(search,newtable);
 	if (min_weight && (search_weight > 0)) {
 		/* Requested clique has not been found. */
 		return 0;
 	}
-	return clique_size[table[i-1]];
+	return search->clique_size[table[i-1]];
 }
 
 
@@ -682,7 +1247,8 @@ static int weighted_clique_search_single(int *table, int min_weight,
  * Returns the number of cliques stored (not neccessarily number of cliques
  * in graph, if user/time_function aborts).
  */
-static int weighted_clique_search_all(int *table, int start,
+static int weighted_clique_search_all(clique_search *search,
+				      int *table, int start,
 				      int min_weight, int max_weight,
 				      boolean maximal, graph_t *g,
 				      clique_options *opts) {
@@ -694,18 +1260,13 @@ static int weighted_clique_search_all(int *table, int start,
 	int newsize;
 	int newweight;
 
-	if (temp_count) {
-		temp_count--;
-		newtable=temp_list[temp_count];
-	} else {
-		newtable=(int*)malloc(g->n * sizeof(int));
-	}
+	newtable=search_table_take(search);
 
-	clique_list_count=0;
-	set_empty(current_clique);
+	search->clique_list_count=0;
+	set_empty(search->current_clique);
 	for (i=start; i < g->n; i++) {
 		v=table[i];
-		clique_size[v]=min_weight;   /* Do not prune here. */
+		search->clique_size[v]=min_weight;   /* Do not prune here. */
 
 		newsize=0;
 		newweight=0;
@@ -717,11 +1278,11 @@ static int weighted_clique_search_all(int *table, int start,
 			}
 		}
 
-		SET_ADD_ELEMENT(current_clique,v);
-		j=sub_weighted_all(newtable,newsize,newweight,
+		SET_ADD_ELEMENT(search->current_clique,v);
+		j=sub_weighted_all(search,newtable,newsize,newweight,
 				   g->weights[v],min_weight-1,INT_MAX,
 				   min_weight,max_weight,maximal,g,opts);
-		SET_DEL_ELEMENT(current_clique,v);
+		SET_DEL_ELEMENT(search->current_clique,v);
 
 		if (j<0) {
 			/* Abort. */
@@ -731,26 +1292,26 @@ static int weighted_clique_search_all(int *table, int start,
 		if (opts->time_function) {
 			gettimeofday(&timeval,NULL);
 			times(&tms);
-			if (!opts->time_function(entrance_level,
-						 i+1,g->n,clique_size[v] *
-						 weight_multiplier,
+			if (!opts->time_function(search->level,
+						 i+1,g->n,search->clique_size[v] *
+						 search->weight_multiplier,
 						 (double)(tms.tms_utime-
-							  cputimer.tms_utime)/
-						 clocks_per_sec,
+							  search->cputimer.tms_utime)/
+						 search->clocks_per_sec,
 						 timeval.tv_sec-
-						 realtimer.tv_sec+
+						 search->realtimer.tv_sec+
 						 (double)(timeval.tv_usec-
-							  realtimer.tv_usec)/
+							  search->realtimer.tv_usec)/
 						 1000000,opts)) {
-				set_free(current_clique);
-				current_clique=NULL;
+				set_free(search->current_clique);
+				search->current_clique=NULL;
 				break;
 			}
 		}
 	}
-	temp_list[temp_count++]=newtable;
+	search_table_return(search,newtable);
 
-	return clique_list_count;
+	return search->clique_list_count;
 }
 
 /*
@@ -793,7 +1354,8 @@ static int weighted_clique_search_all(int *table, int start,
  * searching for all cliques, min_weight should be given the minimum weight
  * desired.
  */
-static int sub_weighted_all(int *table, int size, int weight,
+static int sub_weighted_all(clique_search *search,
+			    int *table, int size, int weight,
 			    int current_weight, int prune_low, int prune_high,
 			    int min_weight, int max_weight, boolean maximal,
 			    graph_t *g, clique_options *opts) {
@@ -805,9 +1367,9 @@ static int sub_weighted_all(int *table, int size, int weight,
 
 	if (current_weight >= min_weight) {
 		if ((current_weight <= max_weight) &&
-		    ((!maximal) || is_maximal(current_clique,g))) {
+		    ((!maximal) || is_maximal(search,search->current_clique,g))) {
 			/* We've found one.  Store it. */
-			if (!store_clique(current_clique,g,opts)) {
+			if (!store_clique(search,search->current_clique,g,opts)) {
 				return -1;
 			}
 		}
@@ -820,8 +1382,8 @@ static int sub_weighted_all(int *table, int size, int weight,
 		/* current_weight < min_weight, prune_low < min_weight,
 		 * so return value is always < min_weight. */
 		if (current_weight>prune_low) {
-			if (best_clique)
-				set_copy(best_clique,current_clique);
+			if (search->best_clique)
+				set_copy(search->best_clique,search->current_clique);
 			if (current_weight < min_weight)
 				return current_weight;
 			else
@@ -832,16 +1394,11 @@ static int sub_weighted_all(int *table, int size, int weight,
 	}
 
 	/* Dynamic memory allocation with cache */
-	if (temp_count) {
-		temp_count--;
-		newtable=temp_list[temp_count];
-	} else {
-		newtable=(int*)malloc(g->n * sizeof(int));
-	}
+	newtable=search_table_take(search);
 
 	for (i = size-1; i >= 0; i--) {
 		v = table[i];
-		if (current_weight+clique_size[v] <= prune_low) {
+		if (current_weight+search->clique_size[v] <= prune_low) {
 			/* Dealing with subset without heavy enough clique. */
 			break;
 		}
@@ -869,20 +1426,20 @@ static int sub_weighted_all(int *table, int size, int weight,
 			continue;
 		}
 
-		SET_ADD_ELEMENT(current_clique,v);
-		prune_low=sub_weighted_all(newtable,p1-newtable,
+		SET_ADD_ELEMENT(search->current_clique,v);
+		prune_low=sub_weighted_all(search,newtable,p1-newtable,
 					   newweight,
 					   current_weight+w,
 					   prune_low,prune_high,
 					   min_weight,max_weight,maximal,
 					   g,opts);
-		SET_DEL_ELEMENT(current_clique,v);
+		SET_DEL_ELEMENT(search->current_clique,v);
 		if ((prune_low<0) || (prune_low>=prune_high)) {
 			/* Impossible to find larger clique. */
 			break;
 		}
 	}
-	temp_list[temp_count++]=newtable;
+	search_table_return(search,newtable);
 	return prune_low;
 }
 
@@ -892,6 +1449,37 @@ static int sub_weighted_all(int *table, int size, int weight,
 /***** Helper functions *****/
 
 
+/*
+ * search_time_function()
+ *
+ * Calls opts->time_function, if there is one, after base-level step i
+ * of g->n with max the best clique size so far.
+ *
+ * Returns FALSE if time_function asked to abort the search; otherwise
+ * returns TRUE.
+ */
+static boolean search_time_function(clique_search *search, int i,
+				    graph_t *g, int max,
+				    clique_options *opts) {
+	struct tms tms;
+	struct timeval timeval;
+
+	if (opts==NULL || opts->time_function==NULL)
+		return TRUE;
+	gettimeofday(&timeval,NULL);
+	times(&tms);
+	return opts->time_function(search->level,
+				   i,g->n,max * search->weight_multiplier,
+				   (double)(tms.tms_utime-
+					    search->cputimer.tms_utime)/
+				   search->clocks_per_sec,
+				   timeval.tv_sec-
+				   search->realtimer.tv_sec+
+				   (double)(timeval.tv_usec-
+					    search->realtimer.tv_usec)/
+				   1000000,opts);
+}
+
 /*
  * store_clique()
  *
@@ -903,9 +1491,10 @@ static int sub_weighted_all(int *table, int size, int weight,
  * Returns FALSE if opts->user_function() returned FALSE; otherwise
  * returns TRUE.
  */
-static boolean store_clique(set_t clique, graph_t *g, clique_options *opts) {
+static boolean store_clique(clique_search *search,
+			    set_t clique, graph_t *g, clique_options *opts) {
 
-	clique_list_count++;
+	search->clique_list_count++;
 
 	/* clique_list[] */
 	if (opts->clique_list) {
@@ -914,14 +1503,14 @@ static boolean store_clique(set_t clique, graph_t *g, clique_options *opts) {
 		 * Has clique_list_count been set to 0 before calling
 		 * the recursions? 
 		 */
-		if (clique_list_count <= 0) {
+		if (search->clique_list_count <= 0) {
 			fprintf(stderr,"CLIQUER INTERNAL ERROR: "
 				"clique_list_count has negative value!\n");
 			fprintf(stderr,"Please report as a bug.\n");
 			abort();
 		}
-		if (clique_list_count <= opts->clique_list_length)
-			opts->clique_list[clique_list_count-1] =
+		if (search->clique_list_count <= opts->clique_list_length)
+			opts->clique_list[search->clique_list_count-1] =
 				set_duplicate(clique);
 	}
 
@@ -978,18 +1567,13 @@ static void maximalize_clique(set_t s,graph_t *g) {
  *
  * Returns TRUE is clique is a maximal clique of g, otherwise FALSE.
  */
-static boolean is_maximal(set_t clique, graph_t *g) {
+static boolean is_maximal(clique_search *search, set_t clique, graph_t *g) {
 	int i,j;
 	int *table;
 	int len;
 	boolean addable;
 
-	if (temp_count) {
-		temp_count--;
-		table=temp_list[temp_count];
-	} else {
-		table=(int*)malloc(g->n * sizeof(int));
-	}
+	table=search_table_take(search);
 
 	len=0;
 	for (i=0; i < g->n; i++)
@@ -1005,11 +1589,11 @@ static boolean is_maximal(set_t clique, graph_t *g) {
 			}
 		}
 		if (addable) {
-			temp_list[temp_count++]=table;
+			search_table_return(search,table);
 			return FALSE;
 		}
 	}
-	temp_list[temp_count++]=table;
+	search_table_return(search,table);
 	return TRUE;
 }
 
@@ -1082,12 +1666,22 @@ int clique_unweighted_max_weight(graph_t *g, clique_options *opts) {
  */
 set_t clique_unweighted_find_single(graph_t *g,int min_size,int max_size,
 				    boolean maximal, clique_options *opts) {
+	return unweighted_find_single(g,min_size,max_size,maximal,opts,1);
+}
+
+/*
+ * unweighted_find_single()
+ *
+ * clique_unweighted_find_single() with the sizes passed to
+ * opts->time_function() multiplied by weight_multiplier.
+ */
+static set_t unweighted_find_single(graph_t *g,int min_size,int max_size,
+				    boolean maximal, clique_options *opts,
+				    int weight_multiplier) {
 	int i;
 	int *table;
 	set_t s;
-
-	ENTRANCE_SAVE();
-	entrance_level++;
+	clique_search search;
 
 	if (opts==NULL)
 		opts=clique_default_options;
@@ -1101,25 +1695,10 @@ set_t clique_unweighted_find_single(graph_t *g,int min_size,int max_size,
 	ASSERT((opts->reorder_function==NULL) || (opts->reorder_map==NULL));
 
 	if ((max_size>0) && (min_size>max_size)) {
-		/* state was not changed */
-		entrance_level--;
 		return NULL;
 	}
 
-	if (clocks_per_sec==0)
-		clocks_per_sec=sysconf(_SC_CLK_TCK);
-	ASSERT(clocks_per_sec>0);
-
-	/* Dynamic allocation */
-	current_clique=set_new(g->n);
-	clique_size=(int*)malloc(g->n * sizeof(int));
-	/* table allocated later */
-	temp_list=(int**)malloc((g->n+2)*sizeof(int *));
-	temp_count=0;
-
-	/* "start clock" */
-	gettimeofday(&realtimer,NULL);
-	times(&cputimer);
+	search_begin(&search,g,weight_multiplier);
 
 	/* reorder */
 	if (opts->reorder_function) {
@@ -1132,15 +1711,15 @@ set_t clique_unweighted_find_single(graph_t *g,int min_size,int max_size,
 	ASSERT(reorder_is_bijection(table,g->n));
 
 
-	if (unweighted_clique_search_single(table,min_size,g,opts)==0) {
-		set_free(current_clique);
-		current_clique=NULL;
+	if (unweighted_clique_search_single(&search,table,min_size,g,opts)==0) {
+		set_free(search.current_clique);
+		search.current_clique=NULL;
 		goto cleanreturn;
 	}
 	if (maximal && (min_size>0)) {
-		maximalize_clique(current_clique,g);
+		maximalize_clique(search.current_clique,g);
 
-		if ((max_size > 0) && (set_size(current_clique) > max_size)) {
+		if ((max_size > 0) && (set_size(search.current_clique) > max_size)) {
 			clique_options localopts;
 
 			s = set_new(g->n);
@@ -1151,32 +1730,27 @@ set_t clique_unweighted_find_single(graph_t *g,int min_size,int max_size,
 			localopts.clique_list_length = 1;
 
 			for (i=0; i < g->n-1; i++)
-				if (clique_size[table[i]]>=min_size)
+				if (search.clique_size[table[i]]>=min_size)
 					break;
-			if (unweighted_clique_search_all(table,i,min_size,
+			if (unweighted_clique_search_all(&search,table,i,min_size,
 							 max_size,maximal,
 							 g,&localopts)) {
-				set_free(current_clique);
-				current_clique=s;
+				set_free(search.current_clique);
+				search.current_clique=s;
 			} else {
-				set_free(current_clique);
-				current_clique=NULL;
+				set_free(search.current_clique);
+				search.current_clique=NULL;
 			}
 		}
 	}
 	
     cleanreturn:
-	s=current_clique;
+	s=search.current_clique;
+	search.current_clique=NULL;
 
 	/* Free resources */
-	for (i=0; i < temp_count; i++)
-		free(temp_list[i]);
-	free(temp_list);
 	free(table);
-	free(clique_size);
-
-	ENTRANCE_RESTORE();
-	entrance_level--;
+	search_end(&search);
 
 	return s;
 }
@@ -1206,12 +1780,22 @@ set_t clique_unweighted_find_single(graph_t *g,int min_size,int max_size,
  */
 int clique_unweighted_find_all(graph_t *g, int min_size, int max_size,
 			       boolean maximal, clique_options *opts) {
+	return unweighted_find_all(g,min_size,max_size,maximal,opts,1);
+}
+
+/*
+ * unweighted_find_all()
+ *
+ * clique_unweighted_find_all() with the sizes passed to
+ * opts->time_function() multiplied by weight_multiplier.
+ */
+static int unweighted_find_all(graph_t *g, int min_size, int max_size,
+			       boolean maximal, clique_options *opts,
+			       int weight_multiplier) {
 	int i;
 	int *table;
 	int count;
-
-	ENTRANCE_SAVE();
-	entrance_level++;
+	clique_search search;
 
 	if (opts==NULL)
 		opts=clique_default_options;
@@ -1225,28 +1809,10 @@ int clique_unweighted_find_all(graph_t *g, int min_size, int max_size,
 	ASSERT((opts->reorder_function==NULL) || (opts->reorder_map==NULL));
 
 	if ((max_size>0) && (min_size>max_size)) {
-		/* state was not changed */
-		entrance_level--;
 		return 0;
 	}
 
-	if (clocks_per_sec==0)
-		clocks_per_sec=sysconf(_SC_CLK_TCK);
-	ASSERT(clocks_per_sec>0);
-
-	/* Dynamic allocation */
-	current_clique=set_new(g->n);
-	clique_size=(int*)malloc(g->n * sizeof(int));
-	/* table allocated later */
-	temp_list=(int**)malloc((g->n+2)*sizeof(int *));
-	temp_count=0;
-
-	clique_list_count=0;
-	memset(clique_size,0,g->n * sizeof(int));
-
-	/* "start clock" */
-	gettimeofday(&realtimer,NULL);
-	times(&cputimer);
+	search_begin(&search,g,weight_multiplier);
 
 	/* reorder */
 	if (opts->reorder_function) {
@@ -1261,13 +1827,13 @@ int clique_unweighted_find_all(graph_t *g, int min_size, int max_size,
 
 	/* Search as normal until there is a chance to find a suitable
 	 * clique. */
-	if (unweighted_clique_search_single(table,min_size,g,opts)==0) {
+	if (unweighted_clique_search_single(&search,table,min_size,g,opts)==0) {
 		count=0;
 		goto cleanreturn;
 	}
 
 	if (min_size==0 && max_size==0) {
-		min_size=max_size=clique_size[table[g->n-1]];
+		min_size=max_size=search.clique_size[table[g->n-1]];
 		maximal=FALSE;  /* No need to test, since we're searching
 				 * for maximum cliques. */
 	}
@@ -1276,22 +1842,15 @@ int clique_unweighted_find_all(graph_t *g, int min_size, int max_size,
 	}
 
 	for (i=0; i < g->n-1; i++)
-		if (clique_size[table[i]] >= min_size)
+		if (search.clique_size[table[i]] >= min_size)
 			break;
-	count=unweighted_clique_search_all(table,i,min_size,max_size,
+	count=unweighted_clique_search_all(&search,table,i,min_size,max_size,
 					   maximal,g,opts);
 
   cleanreturn:
 	/* Free resources */
-	for (i=0; i<temp_count; i++)
-		free(temp_list[i]);
-	free(temp_list);
 	free(table);
-	free(clique_size);
-	set_free(current_clique);
-
-	ENTRANCE_RESTORE();
-	entrance_level--;
+	search_end(&search);
 
 	return count;
 }
@@ -1359,9 +1918,7 @@ set_t clique_find_single(graph_t *g,int min_weight,int max_weight,
 	int i;
 	int *table;
 	set_t s;
-
-	ENTRANCE_SAVE();
-	entrance_level++;
+	clique_search search;
 
 	if (opts==NULL)
 		opts=clique_default_options;
@@ -1375,49 +1932,25 @@ set_t clique_find_single(graph_t *g,int min_weight,int max_weight,
 	ASSERT((opts->reorder_function==NULL) || (opts->reorder_map==NULL));
 
 	if ((max_weight>0) && (min_weight>max_weight)) {
-		/* state was not changed */
-		entrance_level--;
 		return NULL;
 	}
 
-	if (clocks_per_sec==0)
-		clocks_per_sec=sysconf(_SC_CLK_TCK);
-	ASSERT(clocks_per_sec>0);
-
 	/* Check whether we can use unweighted routines. */
 	if (!graph_weighted(g)) {
 		min_weight=DIV_UP(min_weight,g->weights[0]);
 		if (max_weight) {
 			max_weight=DIV_DOWN(max_weight,g->weights[0]);
 			if (max_weight < min_weight) {
-				/* state was not changed */
-				entrance_level--;
 				return NULL;
 			}
 		}
 
-		weight_multiplier = g->weights[0];
-		entrance_level--;
-		s=clique_unweighted_find_single(g,min_weight,max_weight,
-						maximal,opts);
-		ENTRANCE_RESTORE();
-		return s;
+		return unweighted_find_single(g,min_weight,max_weight,
+					      maximal,opts,g->weights[0]);
 	}
 
-	/* Dynamic allocation */
-	current_clique=set_new(g->n);
-	best_clique=set_new(g->n);
-	clique_size=(int*)malloc(g->n * sizeof(int));
-	memset(clique_size, 0, g->n * sizeof(int));
-	/* table allocated later */
-	temp_list=(int**)malloc((g->n+2)*sizeof(int *));
-	temp_count=0;
-
-	clique_list_count=0;
-
-	/* "start clock" */
-	gettimeofday(&realtimer,NULL);
-	times(&cputimer);
+	search_begin(&search,g,1);
+	search.best_clique=set_new(g->n);
 
 	/* reorder */
 	if (opts->reorder_function) {
@@ -1432,54 +1965,44 @@ set_t clique_find_single(graph_t *g,int min_weight,int max_weight,
 	if (max_weight==0)
 		max_weight=INT_MAX;
 
-	if (weighted_clique_search_single(table,min_weight,max_weight,
+	if (weighted_clique_search_single(&search,table,min_weight,max_weight,
 					  g,opts)==0) {
 		/* Requested clique has not been found. */
-		set_free(best_clique);
-		best_clique=NULL;
+		set_free(search.best_clique);
+		search.best_clique=NULL;
 		goto cleanreturn;
 	}
 	if (maximal && (min_weight>0)) {
-		maximalize_clique(best_clique,g);
-		if (graph_subgraph_weight(g,best_clique) > max_weight) {
+		maximalize_clique(search.best_clique,g);
+		if (graph_subgraph_weight(g,search.best_clique) > max_weight) {
 			clique_options localopts;
 
 			localopts.time_function = opts->time_function;
 			localopts.output = opts->output;
 			localopts.user_function = false_function;
-			localopts.clique_list = &best_clique;
+			localopts.clique_list = &search.best_clique;
 			localopts.clique_list_length = 1;
 
 			for (i=0; i < g->n-1; i++)
-				if ((clique_size[table[i]] >= min_weight) ||
-				    (clique_size[table[i]] == 0))
+				if ((search.clique_size[table[i]] >= min_weight) ||
+				    (search.clique_size[table[i]] == 0))
 					break;
-			if (!weighted_clique_search_all(table,i,min_weight,
+			if (!weighted_clique_search_all(&search,table,i,min_weight,
 							max_weight,maximal,
 							g,&localopts)) {
-				set_free(best_clique);
-				best_clique=NULL;
+				set_free(search.best_clique);
+				search.best_clique=NULL;
 			}
 		}
 	}
 
  cleanreturn:
-	s=best_clique;
+	s=search.best_clique;
+	search.best_clique=NULL;
 
 	/* Free resources */
-	for (i=0; i < temp_count; i++)
-		free(temp_list[i]);
-	free(temp_list);
-	temp_list=NULL;
-	temp_count=0;
 	free(table);
-	set_free(current_clique);
-	current_clique=NULL;
-	free(clique_size);
-	clique_size=NULL;
-
-	ENTRANCE_RESTORE();
-	entrance_level--;
+	search_end(&search);
 
 	return s;
 }
@@ -1518,9 +2041,7 @@ int clique_find_all(graph_t *g, int min_weight, int max_weight,
 		    boolean maximal, clique_options *opts) {
 	int i,n;
 	int *table;
-
-	ENTRANCE_SAVE();
-	entrance_level++;
+	clique_search search;
 
 	if (opts==NULL)
 		opts=clique_default_options;
@@ -1534,46 +2055,24 @@ int clique_find_all(graph_t *g, int min_weight, int max_weight,
 	ASSERT((opts->reorder_function==NULL) || (opts->reorder_map==NULL));
 
 	if ((max_weight>0) && (min_weight>max_weight)) {
-		/* state was not changed */
-		entrance_level--;
 		return 0;
 	}
 
-	if (clocks_per_sec==0)
-		clocks_per_sec=sysconf(_SC_CLK_TCK);
-	ASSERT(clocks_per_sec>0);
-
 	if (!graph_weighted(g)) {
 		min_weight=DIV_UP(min_weight,g->weights[0]);
 		if (max_weight) {
 			max_weight=DIV_DOWN(max_weight,g->weights[0]);
 			if (max_weight < min_weight) {
-				/* state was not changed */
-				entrance_level--;
 				return 0;
 			}
 		}
 		
-		weight_multiplier = g->weights[0];
-		entrance_level--;
-		i=clique_unweighted_find_all(g,min_weight,max_weight,maximal,
-					     opts);
-		ENTRANCE_RESTORE();
-		return i;
+		return unweighted_find_all(g,min_weight,max_weight,maximal,
+					   opts,g->weights[0]);
 	}
 
-	/* Dynamic allocation */
-	current_clique=set_new(g->n);
-	best_clique=set_new(g->n);
-	clique_size=(int*)malloc(g->n * sizeof(int));
-	memset(clique_size, 0, g->n * sizeof(int));
-	/* table allocated later */
-	temp_list=(int**)malloc((g->n+2)*sizeof(int *));
-	temp_count=0;
-
-	/* "start clock" */
-	gettimeofday(&realtimer,NULL);
-	times(&cputimer);
+	search_begin(&search,g,1);
+	search.best_clique=set_new(g->n);
 
 	/* reorder */
 	if (opts->reorder_function) {
@@ -1586,7 +2085,7 @@ int clique_find_all(graph_t *g, int min_weight, int max_weight,
 	ASSERT(reorder_is_bijection(table,g->n));
 
 	/* First phase */
-	n=weighted_clique_search_single(table,min_weight,INT_MAX,g,opts);
+	n=weighted_clique_search_single(&search,table,min_weight,INT_MAX,g,opts);
 	if (n==0) {
 		/* Requested clique has not been found. */
 		goto cleanreturn;
@@ -1601,26 +2100,18 @@ int clique_find_all(graph_t *g, int min_weight, int max_weight,
 		max_weight=INT_MAX;
 
 	for (i=0; i < g->n; i++)
-		if ((clique_size[table[i]] >= min_weight) ||
-		    (clique_size[table[i]] == 0))
+		if ((search.clique_size[table[i]] >= min_weight) ||
+		    (search.clique_size[table[i]] == 0))
 			break;
 
 	/* Second phase */
-	n=weighted_clique_search_all(table,i,min_weight,max_weight,maximal,
+	n=weighted_clique_search_all(&search,table,i,min_weight,max_weight,maximal,
 				     g,opts);
 
       cleanreturn:
 	/* Free resources */
-	for (i=0; i < temp_count; i++)
-		free(temp_list[i]);
-	free(temp_list);
 	free(table);
-	set_free(current_clique);
-	set_free(best_clique);
-	free(clique_size);
-
-	ENTRANCE_RESTORE();
-	entrance_level--;
+	search_end(&search);
 
 	return n;
 }
@@ -1660,10 +2151,10 @@ int clique_find_all(graph_t *g, int min_weight, int max_weight,
 boolean clique_print_time(int level, int i, int n, int max,
 			  double cputime, double realtime,
 			  clique_options *opts) {
-	static float prev_time=100;
-	static int prev_i=100;
-	static int prev_max=100;
-	static int prev_level=0;
+	static thread_local float prev_time=100;
+	static thread_local int prev_i=100;
+	static thread_local int prev_max=100;
+	static thread_local int prev_level=0;
 	FILE *fp=opts->output;
 	int j;
 
@@ -1709,8 +2200,8 @@ boolean clique_print_time(int level, int i, int n, int max,
 boolean clique_print_time_always(int level, int i, int n, int max,
 				 double cputime, double realtime,
 				 clique_options *opts) {
-	static float prev_time=100;
-	static int prev_i=100;
+	static thread_local float prev_time=100;
+	static thread_local int prev_i=100;
 	FILE *fp=opts->output;
 	int j;
 
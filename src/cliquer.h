@@ -22,6 +22,12 @@ struct _clique_options {
 	void *user_data;
 	set_t *clique_list;
 	int clique_list_length;
+
+	/* Threads for the base-level steps of the unweighted single clique
+	 * searches, on graphs of any size (0 or 1 searches on the calling
+	 * thread only).  time_function may then be called from any of
+	 * them. */
+	int threads;
 };
 
 extern clique_options *clique_default_options;
@@ -0,0 +1,109 @@
+/*
+ * This file contains sets of a width fixed at compile time.
+ */
+
+#ifndef CLIQUER_FIXED_SET_H
+#define CLIQUER_FIXED_SET_H
+
+#include "set.h"
+
+/*
+ * A fixed_set<N> holds values 0,...,N-1, where N is a multiple of
+ * ELEMENTSIZE.  Unlike set_t it carries no length and is passed by
+ * value, so the loops over its words have constant bounds, unroll
+ * completely and keep small sets in registers.
+ */
+template<int N>
+struct fixed_set {
+	enum { words = N/ELEMENTSIZE };
+	setelement e[words];
+};
+
+template<int N>
+UNUSED_FUNCTION INLINE
+static fixed_set<N> fixed_set_empty() {
+	fixed_set<N> s;
+	int i;
+
+	for (i=0; i < fixed_set<N>::words; i++)
+		s.e[i]=0;
+	return s;
+}
+
+/* The values 0,...,n-1. */
+template<int N>
+UNUSED_FUNCTION INLINE
+static fixed_set<N> fixed_set_below(int n) {
+	fixed_set<N> s;
+	int i;
+
+	for (i=0; i < fixed_set<N>::words; i++) {
+		if (i < n/ELEMENTSIZE)
+			s.e[i]=FULL_ELEMENT;
+		else if (i == n/ELEMENTSIZE)
+			s.e[i]=SET_BIT_MASK(n%ELEMENTSIZE)-1;
+		else
+			s.e[i]=0;
+	}
+	return s;
+}
+
+template<int N>
+UNUSED_FUNCTION INLINE
+static void fixed_set_add(fixed_set<N> &s, int v) {
+	SET_ADD_ELEMENT(s.e,v);
+}
+
+template<int N>
+UNUSED_FUNCTION INLINE
+static void fixed_set_del(fixed_set<N> &s, int v) {
+	SET_DEL_ELEMENT(s.e,v);
+}
+
+template<int N>
+UNUSED_FUNCTION INLINE
+static fixed_set<N> fixed_set_intersection(const fixed_set<N> &a,
+					   const fixed_set<N> &b) {
+	fixed_set<N> s;
+	int i;
+
+	for (i=0; i < fixed_set<N>::words; i++)
+		s.e[i]=SET_ELEMENT_INTERSECT(a.e[i],b.e[i]);
+	return s;
+}
+
+template<int N>
+UNUSED_FUNCTION INLINE
+static int fixed_set_size(const fixed_set<N> &s) {
+	int i,count=0;
+
+	for (i=0; i < fixed_set<N>::words; i++)
+		count+=SET_ELEMENT_BIT_COUNT(s.e[i]);
+	return count;
+}
+
+/* Smallest value in s, or -1 if s is empty. */
+template<int N>
+UNUSED_FUNCTION INLINE
+static int fixed_set_first(const fixed_set<N> &s) {
+	int i;
+
+	for (i=0; i < fixed_set<N>::words; i++)
+		if (s.e[i])
+			return i*ELEMENTSIZE+SET_ELEMENT_FIRST(s.e[i]);
+	return -1;
+}
+
+/* Largest value in s, or -1 if s is empty. */
+template<int N>
+UNUSED_FUNCTION INLINE
+static int fixed_set_last(const fixed_set<N> &s) {
+	int i;
+
+	for (i=fixed_set<N>::words-1; i >= 0; i--)
+		if (s.e[i])
+			return i*ELEMENTSIZE+SET_ELEMENT_LAST(s.e[i]);
+	return -1;
+}
+
+#endif /* !CLIQUER_FIXED_SET_H */
@@ -10,6 +10,7 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <string.h>
+#include <sys/mman.h>
 #include "graph.h"
 
 
@@ -17,6 +18,64 @@ static graph_t *graph_read_dimacs_binary(FILE *fp,char *firstline);
 static graph_t *graph_read_dimacs_ascii(FILE *fp,char *firstline);
 
 
+/*
+ * The edges and weights of a graph live in a single block:
+ *
+ *   edges[0..n-1] | weights[0..n-1] | row 0 | row 1 | ... | row n-1
+ *
+ * Every row starts on a cache line and rows are GRAPH_ROW_STRIDE(n)
+ * setelements apart, so edges[i] is simply the i:th row.  The length
+ * word s[-1] of each row sits in the padding just before it.  Blocks
+ * of at least a huge page are aligned to one and the kernel is asked
+ * to back them with huge pages.
+ */
+#define GRAPH_CACHE_LINE 64
+#define GRAPH_HUGE_PAGE (2*1024*1024)
+#define GRAPH_ROUND_UP(x,a) (((x)+(a)-1)/(a)*(a))
+#define GRAPH_ROW_STRIDE(n) GRAPH_ROUND_UP((n)/ELEMENTSIZE+2, \
+		(int)(GRAPH_CACHE_LINE/sizeof(setelement)))
+
+/*
+ * graph_alloc()
+ *
+ * Allocates the block of g for n vertices with weight 1 and no edges.
+ * The previous block of g, if any, is left alone.
+ */
+static void graph_alloc(graph_t *g, int n) {
+	size_t head,size,align;
+	int stride,i;
+	char *block;
+
+	stride=GRAPH_ROW_STRIDE(n);
+	head=GRAPH_ROUND_UP(n*(sizeof(set_t)+sizeof(int))+sizeof(setelement),
+			    GRAPH_CACHE_LINE);
+	size=head+(size_t)n*stride*sizeof(setelement);
+	align=GRAPH_CACHE_LINE;
+	if (size >= GRAPH_HUGE_PAGE) {
+		align=GRAPH_HUGE_PAGE;
+		size=GRAPH_ROUND_UP(size,GRAPH_HUGE_PAGE);
+	}
+	if (posix_memalign((void **)&block,align,size)!=0) {
+		fprintf(stderr,"Out of memory allocating a graph of %d "
+			"vertices.\n",n);
+		abort();
+	}
+#ifdef MADV_HUGEPAGE
+	if (align==GRAPH_HUGE_PAGE)
+		madvise(block,size,MADV_HUGEPAGE);
+#endif
+	memset(block,0,size);
+
+	g->n=n;
+	g->edges=(set_t *)block;
+	g->weights=(int *)(block+n*sizeof(set_t));
+	for (i=0; i < n; i++) {
+		g->edges[i]=(set_t)(block+head)+(size_t)i*stride;
+		g->edges[i][-1]=n;
+		g->weights[i]=1;
+	}
+}
+
 /*
  * graph_new()
  *
@@ -25,19 +84,12 @@ static graph_t *graph_read_dimacs_ascii(FILE *fp,char *firstline);
  */
 graph_t *graph_new(int n) {
 	graph_t *g;
-	int i;
 
 	ASSERT((sizeof(setelement)*8)==ELEMENTSIZE);
 	ASSERT(n>0);
 
 	g=(graph_t*)malloc(sizeof(graph_t));
-	g->n=n;
-	g->edges=(set_t*)malloc(g->n * sizeof(set_t));
-	g->weights=(int*)malloc(g->n * sizeof(int));
-	for (i=0; i < g->n; i++) {
-		g->edges[i]=set_new(n);
-		g->weights[i]=1;
-	}
+	graph_alloc(g,n);
 	return g;
 }
 
@@ -47,16 +99,10 @@ graph_t *graph_new(int n) {
  * Frees the memory associated with the graph g.
  */
 void graph_free(graph_t *g) {
-	int i;
-
 	ASSERT((sizeof(setelement)*8)==ELEMENTSIZE);
 	ASSERT(g!=NULL);
 	ASSERT(g->n > 0);
 
-	for (i=0; i < g->n; i++) {
-		set_free(g->edges[i]);
-	}
-	free(g->weights);
 	free(g->edges);
 	free(g);
 	return;
@@ -71,7 +117,8 @@ void graph_free(graph_t *g) {
  * If size < g->n, the last g->n - size vertices are removed.
  */
 void graph_resize(graph_t *g, int size) {
-	int i;
+	graph_t old;
+	int i,length;
 
 	ASSERT(g!=NULL);
 	ASSERT(g->n > 0);
@@ -80,24 +127,18 @@ void graph_resize(graph_t *g, int size) {
 	if (g->n == size)
 		return;
 
-	/* Free/alloc extra edge-sets */
-	for (i=size; i < g->n; i++)
-		set_free(g->edges[i]);
-	g->edges=(set_t*)realloc(g->edges, size * sizeof(set_t));
-	for (i=g->n; i < size; i++)
-		g->edges[i]=set_new(size);
-
-	/* Resize original sets */
-	for (i=0; i < MIN(g->n,size); i++) {
-		g->edges[i]=set_resize(g->edges[i],size);
+	old=*g;
+	graph_alloc(g,size);
+	length=MIN(SET_ARRAY_LENGTH(old.edges[0]),SET_ARRAY_LENGTH(g->edges[0]));
+	for (i=0; i < MIN(old.n,size); i++) {
+		memcpy(g->edges[i],old.edges[i],length*sizeof(setelement));
+		/* Drop the removed vertices. */
+		if (size < old.n)
+			g->edges[i][size/ELEMENTSIZE] &=
+				SET_BIT_MASK(size%ELEMENTSIZE)-1;
+		g->weights[i]=old.weights[i];
 	}
-
-	/* Weights */
-	g->weights=(int*)realloc(g->weights,size * sizeof(int));
-	for (i=g->n; i<size; i++)
-		g->weights[i]=1;
-	
-	g->n=size;
+	free(old.edges);
 	return;
 }
 
@@ -382,12 +423,7 @@ static boolean parse_input(char *str,graph_t *g) {
 			return FALSE;
 		if (g->n <= 0)
 			return FALSE;
-		g->edges=(set_t*)calloc(g->n,sizeof(set_t));
-		for (i=0; i<g->n; i++)
-			g->edges[i]=set_new(g->n);
-		g->weights=(int*)calloc(g->n,sizeof(int));
-		for (i=0; i<g->n; i++)
-			g->weights[i]=1;
+		graph_alloc(g,g->n);
 		return TRUE;
 	case 'n':
 		if ((g->n <= 0) || (g->weights == NULL))
@@ -10,6 +10,8 @@ struct _graph_t {
 	set_t *edges;      /* A list of n sets (the edges). */
 	int *weights;      /* A list of n vertex weights. */
 };
+/* The edges, weights and rows share one block owned by the graph: rows
+ * must not be freed or resized on their own. */
 
 
 #define GRAPH_IS_EDGE_FAST(g,i,j)  (SET_CONTAINS_FAST((g)->edges[(i)],(j)))
@@ -19,6 +21,11 @@ struct _graph_t {
 	SET_ADD_ELEMENT((g)->edges[(i)],(j)); \
 	SET_ADD_ELEMENT((g)->edges[(j)],(i)); \
 } while (FALSE)
+#define GRAPH_IS_EDGE_ATOMIC(g,i,j) (SET_CONTAINS_ATOMIC((g)->edges[(i)],(j)))
+#define GRAPH_ADD_EDGE_ATOMIC(g,i,j) do {            \
+	SET_ADD_ELEMENT_ATOMIC((g)->edges[(i)],(j)); \
+	SET_ADD_ELEMENT_ATOMIC((g)->edges[(j)],(i)); \
+} while (FALSE)
 #define GRAPH_DEL_EDGE(g,i,j) do {            \
 	SET_DEL_ELEMENT((g)->edges[(i)],(j)); \
 	SET_DEL_ELEMENT((g)->edges[(j)],(i)); \
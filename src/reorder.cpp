@@ -65,21 +65,26 @@ void reorder_set(set_t s,int *order) {
  * Note: Assumes that order is of size g->n.
  */
 void reorder_graph(graph_t *g, int *order) {
-        int i;
-        set_t *tmp_e;
+        int i,length;
+        setelement *tmp_e;
         int *tmp_w;
 
         ASSERT(reorder_is_bijection(order,g->n));
 
-        tmp_e=(set_t*)malloc(g->n * sizeof(set_t));
+        /* Rows are moved by content, as edges[i] stays the i:th row of
+         * the graph's block. */
+        length=SET_ARRAY_LENGTH(g->edges[0]);
+        tmp_e=(setelement*)malloc((size_t)g->n * length * sizeof(setelement));
         tmp_w=(int*)malloc(g->n * sizeof(int));
         for (i=0; i<g->n; i++) {
                 reorder_set(g->edges[i],order);
-                tmp_e[order[i]]=g->edges[i];
+                memcpy(tmp_e+(size_t)order[i]*length,g->edges[i],
+                       length*sizeof(setelement));
                 tmp_w[order[i]]=g->weights[i];
         }
         for (i=0; i<g->n; i++) {
-                g->edges[i]=tmp_e[i];
+                memcpy(g->edges[i],tmp_e+(size_t)i*length,
+                       length*sizeof(setelement));
                 g->weights[i]=tmp_w[i];
         }
         free(tmp_e);
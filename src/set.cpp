@@ -0,0 +1,285 @@
+/*
+ * This file contains the bulk set kernels and picks the ones to use.
+ */
+
+#include "set.h"
+
+/* The x86 kernels take setelements as 64-bit lanes. */
+#if defined(__GNUC__) && defined(__x86_64__) && (ELEMENTSIZE==64)
+# define SET_KERNELS_X86
+# include <immintrin.h>
+# if defined(__clang__) ? (__clang_major__ >= 7) : (__GNUC__ >= 8)
+#  define SET_KERNELS_AVX512
+# endif
+#endif
+
+
+/*** Portable kernels ***/
+
+static int scalar_size(const setelement *s,int length) {
+	int i,count=0;
+
+	for (i=0; i<length; i++)
+		count+=SET_ELEMENT_BIT_COUNT(s[i]);
+	return count;
+}
+
+static void scalar_intersection(setelement *res,const setelement *a,
+				const setelement *b,int length) {
+	int i;
+
+	for (i=0; i<length; i++)
+		res[i]=SET_ELEMENT_INTERSECT(a[i],b[i]);
+}
+
+static void scalar_unite(setelement *res,const setelement *a,
+			 const setelement *b,int length) {
+	int i;
+
+	for (i=0; i<length; i++)
+		res[i]=SET_ELEMENT_UNION(a[i],b[i]);
+}
+
+static void scalar_remove(setelement *a,const setelement *b,int length) {
+	int i;
+
+	for (i=0; i<length; i++)
+		a[i]=SET_ELEMENT_DIFFERENCE(a[i],b[i]);
+}
+
+static const set_kernels scalar_kernels = {
+	"scalar", scalar_size, scalar_intersection, scalar_unite, scalar_remove
+};
+
+
+#ifdef SET_KERNELS_X86
+
+/*** POPCNT instruction ***/
+
+__attribute__((target("popcnt")))
+static int popcnt_size(const setelement *s,int length) {
+	int i,count=0;
+
+	for (i=0; i<length; i++)
+		count+=__builtin_popcountl(s[i]);
+	return count;
+}
+
+static const set_kernels popcnt_kernels = {
+	"popcnt", popcnt_size, scalar_intersection, scalar_unite, scalar_remove
+};
+
+
+/*** AVX2, four setelements at a time ***/
+
+/*
+ * Counts the bits of each nibble with a shuffle from a 16-entry table,
+ * then sums the bytes of each lane with vpsadbw.
+ */
+__attribute__((target("avx2,popcnt")))
+static int avx2_size(const setelement *s,int length) {
+	const __m256i table=_mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,
+					     0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+	const __m256i low=_mm256_set1_epi8(0x0F);
+	__m256i sum=_mm256_setzero_si256();
+	__m256i v,bytes;
+	int i,count;
+
+	for (i=0; i+4 <= length; i+=4) {
+		v=_mm256_loadu_si256((const __m256i *)(s+i));
+		bytes=_mm256_add_epi8(
+			_mm256_shuffle_epi8(table,_mm256_and_si256(v,low)),
+			_mm256_shuffle_epi8(table,_mm256_and_si256(
+						    _mm256_srli_epi16(v,4),low)));
+		sum=_mm256_add_epi64(sum,_mm256_sad_epu8(bytes,
+							 _mm256_setzero_si256()));
+	}
+	count=_mm256_extract_epi64(sum,0)+_mm256_extract_epi64(sum,1)+
+		_mm256_extract_epi64(sum,2)+_mm256_extract_epi64(sum,3);
+	for (; i<length; i++)
+		count+=__builtin_popcountl(s[i]);
+	return count;
+}
+
+__attribute__((target("avx2")))
+static void avx2_intersection(setelement *res,const setelement *a,
+			      const setelement *b,int length) {
+	int i;
+
+	for (i=0; i+4 <= length; i+=4)
+		_mm256_storeu_si256((__m256i *)(res+i),_mm256_and_si256(
+			_mm256_loadu_si256((const __m256i *)(a+i)),
+			_mm256_loadu_si256((const __m256i *)(b+i))));
+	for (; i<length; i++)
+		res[i]=SET_ELEMENT_INTERSECT(a[i],b[i]);
+}
+
+__attribute__((target("avx2")))
+static void avx2_unite(setelement *res,const setelement *a,
+		       const setelement *b,int length) {
+	int i;
+
+	for (i=0; i+4 <= length; i+=4)
+		_mm256_storeu_si256((__m256i *)(res+i),_mm256_or_si256(
+			_mm256_loadu_si256((const __m256i *)(a+i)),
+			_mm256_loadu_si256((const __m256i *)(b+i))));
+	for (; i<length; i++)
+		res[i]=SET_ELEMENT_UNION(a[i],b[i]);
+}
+
+__attribute__((target("avx2")))
+static void avx2_remove(setelement *a,const setelement *b,int length) {
+	int i;
+
+	for (i=0; i+4 <= length; i+=4)
+		_mm256_storeu_si256((__m256i *)(a+i),_mm256_andnot_si256(
+			_mm256_loadu_si256((const __m256i *)(b+i)),
+			_mm256_loadu_si256((const __m256i *)(a+i))));
+	for (; i<length; i++)
+		a[i]=SET_ELEMENT_DIFFERENCE(a[i],b[i]);
+}
+
+static const set_kernels avx2_kernels = {
+	"avx2", avx2_size, avx2_intersection, avx2_unite, avx2_remove
+};
+
+
+#ifdef SET_KERNELS_AVX512
+
+/*** AVX-512, eight setelements at a time with masked tails ***/
+
+#define AVX512_TAIL(i,length) ((__mmask8)((1u << ((length)-(i)))-1))
+/* a&~b.  _mm512_andnot_si512() and _mm512_reduce_add_epi64() trip
+ * uninitialized warnings in the headers of some GCC versions. */
+#define AVX512_DIFFERENCE(a,b) _mm512_ternarylogic_epi64(a,b,b,0x30)
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+static int avx512_size(const setelement *s,int length) {
+	__m512i sum=_mm512_setzero_si512();
+	setelement lanes[8];
+	int i,count=0;
+
+	for (i=0; i+8 <= length; i+=8)
+		sum=_mm512_add_epi64(sum,_mm512_popcnt_epi64(
+					     _mm512_loadu_si512(s+i)));
+	if (i<length)
+		sum=_mm512_add_epi64(sum,_mm512_popcnt_epi64(
+			_mm512_maskz_loadu_epi64(AVX512_TAIL(i,length),s+i)));
+	_mm512_storeu_si512(lanes,sum);
+	for (i=0; i<8; i++)
+		count+=lanes[i];
+	return count;
+}
+
+__attribute__((target("avx512f")))
+static void avx512_intersection(setelement *res,const setelement *a,
+				const setelement *b,int length) {
+	__mmask8 m;
+	int i;
+
+	for (i=0; i+8 <= length; i+=8)
+		_mm512_storeu_si512(res+i,_mm512_and_si512(
+					    _mm512_loadu_si512(a+i),
+					    _mm512_loadu_si512(b+i)));
+	if (i<length) {
+		m=AVX512_TAIL(i,length);
+		_mm512_mask_storeu_epi64(res+i,m,_mm512_and_si512(
+			_mm512_maskz_loadu_epi64(m,a+i),
+			_mm512_maskz_loadu_epi64(m,b+i)));
+	}
+}
+
+__attribute__((target("avx512f")))
+static void avx512_unite(setelement *res,const setelement *a,
+			 const setelement *b,int length) {
+	__mmask8 m;
+	int i;
+
+	for (i=0; i+8 <= length; i+=8)
+		_mm512_storeu_si512(res+i,_mm512_or_si512(
+					    _mm512_loadu_si512(a+i),
+					    _mm512_loadu_si512(b+i)));
+	if (i<length) {
+		m=AVX512_TAIL(i,length);
+		_mm512_mask_storeu_epi64(res+i,m,_mm512_or_si512(
+			_mm512_maskz_loadu_epi64(m,a+i),
+			_mm512_maskz_loadu_epi64(m,b+i)));
+	}
+}
+
+__attribute__((target("avx512f")))
+static void avx512_remove(setelement *a,const setelement *b,int length) {
+	__mmask8 m;
+	int i;
+
+	for (i=0; i+8 <= length; i+=8)
+		_mm512_storeu_si512(a+i,AVX512_DIFFERENCE(
+					    _mm512_loadu_si512(a+i),
+					    _mm512_loadu_si512(b+i)));
+	if (i<length) {
+		m=AVX512_TAIL(i,length);
+		_mm512_mask_storeu_epi64(a+i,m,AVX512_DIFFERENCE(
+			_mm512_maskz_loadu_epi64(m,a+i),
+			_mm512_maskz_loadu_epi64(m,b+i)));
+	}
+}
+
+static const set_kernels avx512_kernels = {
+	"avx512", avx512_size, avx512_intersection, avx512_unite, avx512_remove
+};
+
+#endif  /* SET_KERNELS_AVX512 */
+#endif  /* SET_KERNELS_X86 */
+
+
+/*** Selection ***/
+
+const set_kernels *const set_kernels_all[] = {
+	&scalar_kernels,
+#ifdef SET_KERNELS_X86
+	&popcnt_kernels,
+	&avx2_kernels,
+#ifdef SET_KERNELS_AVX512
+	&avx512_kernels,
+#endif
+#endif
+	NULL
+};
+
+/* Scalar until set_kernels_select() below runs at startup. */
+const set_kernels *set_kernel=&scalar_kernels;
+
+static boolean set_kernels_supported(const set_kernels *k) {
+#ifdef SET_KERNELS_X86
+	__builtin_cpu_init();
+	if (k==&popcnt_kernels)
+		return __builtin_cpu_supports("popcnt");
+	if (k==&avx2_kernels)
+		return __builtin_cpu_supports("avx2") &&
+			__builtin_cpu_supports("popcnt");
+#ifdef SET_KERNELS_AVX512
+	if (k==&avx512_kernels)
+		return __builtin_cpu_supports("avx512f") &&
+			__builtin_cpu_supports("avx512vpopcntdq");
+#endif
+#endif
+	return TRUE;
+}
+
+boolean set_kernels_select(const char *name) {
+	const set_kernels *const *k;
+	const set_kernels *best=NULL;
+
+	for (k=set_kernels_all; *k; k++) {
+		if (name && strcmp((*k)->name,name)!=0)
+			continue;
+		if (set_kernels_supported(*k))
+			best=*k;
+	}
+	if (best==NULL)
+		return FALSE;
+	set_kernel=best;
+	return TRUE;
+}
+
+static boolean set_kernels_selected=set_kernels_select(NULL);
@@ -48,6 +48,7 @@ typedef setelement * set_t;
 /*** Counting amount of 1 bits in a setelement ***/
 
 /* Array for amount of 1 bits in a byte. */
+UNUSED_FUNCTION
 static int set_bit_count[256] = {
 	0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,
 	1,2,2,3,2,3,3,4,2,3,3,4,3,4,4,5,
@@ -97,6 +98,40 @@ static int set_bit_count[256] = {
 # error "SET_ELEMENT_BIT_COUNT(a) not defined for current ELEMENTSIZE"
 #endif
 
+/*
+ * SET_ELEMENT_FIRST(a) and SET_ELEMENT_LAST(a) give the lowest and the
+ * highest bit set in a, which must be non-zero.  With GCC they and
+ * SET_ELEMENT_BIT_COUNT(a) are single instructions where the target
+ * has them.
+ */
+#ifdef __GNUC__
+# undef SET_ELEMENT_BIT_COUNT
+# define SET_ELEMENT_BIT_COUNT(a) __builtin_popcountl(a)
+# define SET_ELEMENT_FIRST(a) __builtin_ctzl(a)
+# define SET_ELEMENT_LAST(a) (ELEMENTSIZE-1-__builtin_clzl(a))
+#else
+UNUSED_FUNCTION INLINE
+static int set_element_first(setelement a) {
+	int i=0;
+	while (!(a&1)) {
+		a>>=1;
+		i++;
+	}
+	return i;
+}
+UNUSED_FUNCTION INLINE
+static int set_element_last(setelement a) {
+	int i=-1;
+	while (a) {
+		a>>=1;
+		i++;
+	}
+	return i;
+}
+# define SET_ELEMENT_FIRST(a) set_element_first(a)
+# define SET_ELEMENT_LAST(a) set_element_last(a)
+#endif
+
 
 
 /*** Macros and functions ***/
@@ -130,12 +165,49 @@ static int set_bit_count[256] = {
 						      (a)%ELEMENTSIZE))
 #define SET_CONTAINS(s,a) (((a)<SET_MAX_SIZE(s))?SET_CONTAINS_FAST(s,a):FALSE)
 
+/* Variants that are safe while other threads add elements to the same set */
+#define SET_ADD_ELEMENT_ATOMIC(s,a) \
+                       __atomic_fetch_or(&(s)[(a)/ELEMENTSIZE], \
+					 SET_BIT_MASK((a)%ELEMENTSIZE),__ATOMIC_RELAXED)
+#define SET_CONTAINS_ATOMIC(s,a) \
+                       (SET_ELEMENT_CONTAINS(__atomic_load_n(&(s)[(a)/ELEMENTSIZE], \
+							     __ATOMIC_RELAXED),(a)%ELEMENTSIZE))
+
 /* Sets can hold values between 0,...,SET_MAX_SIZE(s)-1 */
 #define SET_MAX_SIZE(s) ((s)[-1])
 /* Sets consist of an array of SET_ARRAY_LENGTH(s) setelements */
 #define SET_ARRAY_LENGTH(s) (((s)[-1]+ELEMENTSIZE-1)/ELEMENTSIZE)
 
 
+/*** Bulk kernels ***/
+
+/*
+ * set_size(), set_intersection(), set_union() and set_remove() hand
+ * sets of at least SET_KERNEL_MIN_LENGTH setelements to the loops in
+ * set_kernel; shorter ones are not worth the call.  set.cpp makes it
+ * the fastest table the CPU supports before main() runs.
+ */
+#define SET_KERNEL_MIN_LENGTH 8
+
+typedef struct _set_kernels set_kernels;
+struct _set_kernels {
+	const char *name;
+	int (*size)(const setelement *s,int length);
+	void (*intersection)(setelement *res,const setelement *a,
+			     const setelement *b,int length);
+	void (*unite)(setelement *res,const setelement *a,
+		      const setelement *b,int length);
+	void (*remove)(setelement *a,const setelement *b,int length);
+};
+
+extern const set_kernels *set_kernel;
+/* Every table built in, slowest first, NULL terminated. */
+extern const set_kernels *const set_kernels_all[];
+/* Makes the named table (or with NULL, the fastest one) set_kernel.
+ * Returns FALSE if there is no such table or the CPU lacks support. */
+extern boolean set_kernels_select(const char *name);
+
+
 /*
  * set_new()
  *
@@ -204,6 +276,8 @@ static int set_size(set_t s) {
 	int count=0;
 	setelement *c;
 
+	if (SET_ARRAY_LENGTH(s) >= SET_KERNEL_MIN_LENGTH)
+		return set_kernel->size(s,SET_ARRAY_LENGTH(s));
 	for (c=s; c < s+SET_ARRAY_LENGTH(s); c++)
 		count+=SET_ELEMENT_BIT_COUNT(*c);
 	return count;
@@ -282,6 +356,10 @@ static set_t set_intersection(set_t res,set_t a,set_t b) {
 	}
 
 	max=MIN(SET_ARRAY_LENGTH(a),SET_ARRAY_LENGTH(b));
+	if (max >= SET_KERNEL_MIN_LENGTH) {
+		set_kernel->intersection(res,a,b,max);
+		return res;
+	}
 	for (i=0; i<max; i++) {
 		res[i]=SET_ELEMENT_INTERSECT(a[i],b[i]);
 	}
@@ -294,6 +372,10 @@ static void set_remove(set_t a,set_t b) {
 	int i,max;
 
 	max=MIN(SET_ARRAY_LENGTH(a),SET_ARRAY_LENGTH(b));
+	if (max >= SET_KERNEL_MIN_LENGTH) {
+		set_kernel->remove(a,b,max);
+		return;
+	}
 	for (i=0; i<max; i++) {
 		a[i]=SET_ELEMENT_DIFFERENCE(a[i],b[i]);
 	}
@@ -325,6 +407,10 @@ static set_t set_union(set_t res,set_t a,set_t b) {
 	}
 
 	max=MAX(SET_ARRAY_LENGTH(a),SET_ARRAY_LENGTH(b));
+	if (max >= SET_KERNEL_MIN_LENGTH) {
+		set_kernel->unite(res,a,b,max);
+		return res;
+	}
 	for (i=0; i<max; i++) {
 		res[i]=SET_ELEMENT_UNION(a[i],b[i]);
 	}
@@ -348,6 +434,9 @@ static set_t set_union(set_t res,set_t a,set_t b) {
  */
 UNUSED_FUNCTION INLINE
 static int set_return_next(set_t s, int n) {
+	int i,length;
+	setelement e;
+
 	if (n<0)
 		n=0;
 	else
@@ -355,24 +444,19 @@ static int set_return_next(set_t s, int n) {
 	if (n >= SET_MAX_SIZE(s))
 		return -1;
 
-	while (n%ELEMENTSIZE) {
-		if (SET_CONTAINS(s,n))
-			return n;
-		n++;
-		if (n >= SET_MAX_SIZE(s))
-			return -1;
-	}
-
-	while (s[n/ELEMENTSIZE]==0) {
-		n+=ELEMENTSIZE;
-		if (n >= SET_MAX_SIZE(s))
-			return -1;
-	}
-	while (!SET_CONTAINS(s,n)) {
-		n++;
-		if (n >= SET_MAX_SIZE(s))
+	/* Skip whole setelements, then take the lowest bit left. */
+	i=n/ELEMENTSIZE;
+	e=s[i] & (FULL_ELEMENT << (n%ELEMENTSIZE));
+	length=SET_ARRAY_LENGTH(s);
+	while (e==0) {
+		i++;
+		if (i >= length)
 			return -1;
+		e=s[i];
 	}
+	n=i*ELEMENTSIZE+SET_ELEMENT_FIRST(e);
+	if (n >= SET_MAX_SIZE(s))
+		return -1;
 	return n;
 }
 